@@ -0,0 +1,73 @@
+#pragma once
+#include "vector.h"
+
+#include <cstddef>
+#include <new>
+#include <numeric>
+#include <type_traits>
+
+// Allocator whose blocks start at a multiple of Alignment and span whole multiples of it.
+// Kernels may read a block up to the next Alignment boundary after its last element, and
+// no other allocation shares a cache line with it when Alignment is the line size
+template <typename T, size_t Alignment>
+class AlignedAllocator {
+    static_assert(Alignment != 0 && (Alignment & (Alignment - 1)) == 0, "alignment must be a power of two");
+    static_assert(Alignment >= alignof(T), "alignment must not be weaker than the alignment of T");
+
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>& /*other*/) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        if (n > (static_cast<size_t>(-1) - Alignment) / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(::operator new(PaddedBytes(n), std::align_val_t{ Alignment }));
+    }
+
+    void deallocate(T* buf, size_t n) noexcept {
+        ::operator delete(buf, PaddedBytes(n), std::align_val_t{ Alignment });
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>& /*other*/) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>& /*other*/) const noexcept {
+        return false;
+    }
+
+private:
+    static size_t PaddedBytes(size_t n) noexcept {
+        return (n * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+    }
+};
+
+// Wraps a growth policy so that every capacity it picks fills whole Alignment-sized
+// blocks, i.e. the padding left by AlignedAllocator becomes usable capacity
+template <size_t Alignment, typename Base = DefaultGrowth>
+struct AlignedGrowth : Base {
+    static constexpr size_t NextCapacity(size_t capacity, size_t required, size_t elem_size) noexcept {
+        const size_t next = Base::NextCapacity(capacity, required, elem_size);
+        const size_t lanes = Alignment / std::gcd(Alignment, elem_size);
+        return next <= static_cast<size_t>(-1) / elem_size - lanes ? (next + lanes - 1) / lanes * lanes : next;
+    }
+};
+
+// Vector for SIMD kernels: the buffer is aligned to Alignment (64 fits AVX-512 and cache
+// lines) and grown in whole vector widths
+template <typename T, size_t Alignment = 64, typename Growth = AlignedGrowth<Alignment>>
+using AlignedVector = Vector<T, AlignedAllocator<T, Alignment>, Growth>;
@@ -0,0 +1,270 @@
+#include "test_types.h"
+#include "vector.h"
+#include "vector_ops.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Compares Vector<T> against std::vector<T>. Results can be exported with
+//   --benchmark_out=results.json --benchmark_out_format=json
+
+namespace {
+
+    struct Pod256 {
+        std::uint64_t words[32];
+    };
+
+    template <typename T>
+    T MakeValue(size_t i) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            return static_cast<T>(i);
+        }
+        else if constexpr (std::is_same_v<T, std::string>) {
+            // Long enough to defeat the small string optimization
+            return std::string(32, static_cast<char>('a' + i % 26));
+        }
+        else if constexpr (std::is_same_v<T, Obj>) {
+            return Obj(static_cast<int>(i));
+        }
+        else if constexpr (std::is_same_v<T, Pod256>) {
+            Pod256 pod{};
+            pod.words[0] = i;
+            return pod;
+        }
+        else {
+            return T{};
+        }
+    }
+
+    template <typename T>
+    void PushBack(std::vector<T>& v, const T& value) {
+        v.push_back(value);
+    }
+
+    template <typename T>
+    void PushBack(Vector<T>& v, const T& value) {
+        v.PushBack(value);
+    }
+
+    template <typename T>
+    void EmplaceBack(std::vector<T>& v, T&& value) {
+        v.emplace_back(std::move(value));
+    }
+
+    template <typename T>
+    void EmplaceBack(Vector<T>& v, T&& value) {
+        v.EmplaceBack(std::move(value));
+    }
+
+    template <typename T>
+    void Reserve(std::vector<T>& v, size_t capacity) {
+        v.reserve(capacity);
+    }
+
+    template <typename T>
+    void Reserve(Vector<T>& v, size_t capacity) {
+        v.Reserve(capacity);
+    }
+
+    template <typename T>
+    void EmplaceEraseMiddle(std::vector<T>& v, T&& value) {
+        auto pos = v.emplace(v.begin() + v.size() / 2, std::move(value));
+        v.erase(pos);
+    }
+
+    template <typename T>
+    void EmplaceEraseMiddle(Vector<T>& v, T&& value) {
+        auto pos = v.Emplace(v.begin() + v.Size() / 2, std::move(value));
+        v.Erase(pos);
+    }
+
+    template <typename Container>
+    Container MakeFilled(size_t size) {
+        using T = typename Container::value_type;
+        Container v;
+        Reserve(v, size);
+        for (size_t i = 0; i < size; ++i) {
+            PushBack(v, MakeValue<T>(i));
+        }
+        return v;
+    }
+
+    template <typename Container>
+    void BM_PushBack(benchmark::State& state) {
+        using T = typename Container::value_type;
+        const auto size = static_cast<size_t>(state.range(0));
+        const T value = MakeValue<T>(size);
+        for (auto _ : state) {
+            Container v;
+            for (size_t i = 0; i < size; ++i) {
+                PushBack(v, value);
+            }
+            benchmark::DoNotOptimize(v.begin());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    template <typename Container>
+    void BM_EmplaceBack(benchmark::State& state) {
+        using T = typename Container::value_type;
+        const auto size = static_cast<size_t>(state.range(0));
+        for (auto _ : state) {
+            Container v;
+            for (size_t i = 0; i < size; ++i) {
+                EmplaceBack(v, MakeValue<T>(i));
+            }
+            benchmark::DoNotOptimize(v.begin());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    template <typename Container>
+    void BM_ReservePushBack(benchmark::State& state) {
+        using T = typename Container::value_type;
+        const auto size = static_cast<size_t>(state.range(0));
+        const T value = MakeValue<T>(size);
+        for (auto _ : state) {
+            Container v;
+            Reserve(v, size);
+            for (size_t i = 0; i < size; ++i) {
+                PushBack(v, value);
+            }
+            benchmark::DoNotOptimize(v.begin());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    template <typename Container>
+    void BM_EmplaceEraseMiddle(benchmark::State& state) {
+        using T = typename Container::value_type;
+        Container v = MakeFilled<Container>(static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            EmplaceEraseMiddle(v, MakeValue<T>(0));
+            benchmark::ClobberMemory();
+        }
+    }
+
+    // Assignment to a vector of the same size reuses its capacity
+    template <typename Container>
+    void BM_CopyAssign(benchmark::State& state) {
+        const auto size = static_cast<size_t>(state.range(0));
+        const Container source = MakeFilled<Container>(size);
+        Container target = MakeFilled<Container>(size);
+        for (auto _ : state) {
+            target = source;
+            benchmark::DoNotOptimize(target.begin());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    template <typename Container>
+    void BM_Iterate(benchmark::State& state) {
+        const Container v = MakeFilled<Container>(static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            for (const auto& elem : v) {
+                benchmark::DoNotOptimize(elem);
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    template <typename T>
+    void BM_SumAccumulate(benchmark::State& state) {
+        const auto v = MakeFilled<Vector<T>>(static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(std::accumulate(v.begin(), v.end(), vector_ops::detail::SumType<T>{}));
+        }
+        state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<int64_t>(sizeof(T)));
+    }
+
+    template <typename T>
+    void BM_SumVectorOps(benchmark::State& state) {
+        const auto v = MakeFilled<Vector<T>>(static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(vector_ops::Sum(v.Data(), v.Data() + v.Size()));
+        }
+        state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<int64_t>(sizeof(T)));
+    }
+
+    // Decodes ints in chunks, as a stream reader does: one PushBack per element against
+    // one PrepareAppend/CommitAppend per chunk written in place
+    constexpr size_t CHUNK = 256;
+
+    void BM_ChunkPushBack(benchmark::State& state) {
+        const auto size = static_cast<size_t>(state.range(0));
+        for (auto _ : state) {
+            Vector<int> v;
+            for (size_t done = 0; done < size; done += CHUNK) {
+                const size_t count = std::min(CHUNK, size - done);
+                for (size_t i = 0; i < count; ++i) {
+                    v.PushBack(static_cast<int>((done + i) * 3));
+                }
+            }
+            benchmark::DoNotOptimize(v.Data());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_ChunkPrepareAppend(benchmark::State& state) {
+        const auto size = static_cast<size_t>(state.range(0));
+        for (auto _ : state) {
+            Vector<int> v;
+            for (size_t done = 0; done < size; done += CHUNK) {
+                const size_t count = std::min(CHUNK, size - done);
+                int* out = v.PrepareAppend(count);
+                for (size_t i = 0; i < count; ++i) {
+                    out[i] = static_cast<int>((done + i) * 3);
+                }
+                v.CommitAppend(count);
+            }
+            benchmark::DoNotOptimize(v.Data());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    template <int64_t MaxSize>
+    void Sizes(benchmark::internal::Benchmark* benchmark) {
+        benchmark->RangeMultiplier(16)->Range(16, MaxSize);
+    }
+
+    constexpr int64_t LARGE = 100'000'000;
+    constexpr int64_t MEDIUM = 1'000'000;
+
+}  // namespace
+
+// Middle insertion is linear, so it stops at smaller sizes than the rest
+#define VECTOR_BENCHMARKS(Type, MaxSize)                                                         \
+    BENCHMARK_TEMPLATE(BM_PushBack, std::vector<Type>)->Apply(Sizes<MaxSize>);                   \
+    BENCHMARK_TEMPLATE(BM_PushBack, Vector<Type>)->Apply(Sizes<MaxSize>);                        \
+    BENCHMARK_TEMPLATE(BM_EmplaceBack, std::vector<Type>)->Apply(Sizes<MaxSize>);                \
+    BENCHMARK_TEMPLATE(BM_EmplaceBack, Vector<Type>)->Apply(Sizes<MaxSize>);                     \
+    BENCHMARK_TEMPLATE(BM_ReservePushBack, std::vector<Type>)->Apply(Sizes<MaxSize>);            \
+    BENCHMARK_TEMPLATE(BM_ReservePushBack, Vector<Type>)->Apply(Sizes<MaxSize>);                 \
+    BENCHMARK_TEMPLATE(BM_EmplaceEraseMiddle, std::vector<Type>)->Apply(Sizes<MEDIUM>);          \
+    BENCHMARK_TEMPLATE(BM_EmplaceEraseMiddle, Vector<Type>)->Apply(Sizes<MEDIUM>);               \
+    BENCHMARK_TEMPLATE(BM_CopyAssign, std::vector<Type>)->Apply(Sizes<MaxSize>);                 \
+    BENCHMARK_TEMPLATE(BM_CopyAssign, Vector<Type>)->Apply(Sizes<MaxSize>);                      \
+    BENCHMARK_TEMPLATE(BM_Iterate, std::vector<Type>)->Apply(Sizes<MaxSize>);                    \
+    BENCHMARK_TEMPLATE(BM_Iterate, Vector<Type>)->Apply(Sizes<MaxSize>)
+
+VECTOR_BENCHMARKS(int, LARGE);
+VECTOR_BENCHMARKS(std::string, MEDIUM);
+VECTOR_BENCHMARKS(Obj, MEDIUM);
+VECTOR_BENCHMARKS(C, MEDIUM);
+VECTOR_BENCHMARKS(Pod256, MEDIUM);
+
+BENCHMARK_TEMPLATE(BM_SumAccumulate, int)->Apply(Sizes<LARGE>);
+BENCHMARK_TEMPLATE(BM_SumVectorOps, int)->Apply(Sizes<LARGE>);
+BENCHMARK_TEMPLATE(BM_SumAccumulate, float)->Apply(Sizes<LARGE>);
+BENCHMARK_TEMPLATE(BM_SumVectorOps, float)->Apply(Sizes<LARGE>);
+
+BENCHMARK(BM_ChunkPushBack)->Apply(Sizes<LARGE>);
+BENCHMARK(BM_ChunkPrepareAppend)->Apply(Sizes<LARGE>);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,315 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace detail {
+
+inline size_t PopcountWordsPortable(const uint64_t* words, size_t count) noexcept {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += static_cast<size_t>(__builtin_popcountll(words[i]));
+    }
+    return total;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Without the target attribute __builtin_popcountll is a library call on baseline x86-64
+__attribute__((target("popcnt"))) inline size_t PopcountWordsPopcnt(const uint64_t* words, size_t count) noexcept {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += static_cast<size_t>(__builtin_popcountll(words[i]));
+    }
+    return total;
+}
+
+// Counts eight words per instruction
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt"))) inline size_t PopcountWordsAvx512(const uint64_t* words,
+                                                                                          size_t count) noexcept {
+    __m512i sums = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        sums = _mm512_add_epi64(sums, _mm512_popcnt_epi64(_mm512_loadu_si512(words + i)));
+    }
+    // Reduced by hand: _mm512_reduce_add_epi64 trips -Wuninitialized in GCC 12's headers
+    alignas(64) uint64_t lanes[8];
+    _mm512_store_si512(lanes, sums);
+    size_t total = 0;
+    for (const uint64_t lane : lanes) {
+        total += static_cast<size_t>(lane);
+    }
+    for (; i < count; ++i) {
+        total += static_cast<size_t>(__builtin_popcountll(words[i]));
+    }
+    return total;
+}
+#endif
+
+inline size_t PopcountWords(const uint64_t* words, size_t count) noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    static const auto kernel = [] {
+        if (__builtin_cpu_supports("avx512vpopcntdq") && __builtin_cpu_supports("avx512f")) {
+            return &PopcountWordsAvx512;
+        }
+        return __builtin_cpu_supports("popcnt") ? &PopcountWordsPopcnt : &PopcountWordsPortable;
+    }();
+    return kernel(words, count);
+#else
+    return PopcountWordsPortable(words, count);
+#endif
+}
+
+}  // namespace detail
+
+// Vector of bits packed 64 per word into RawMemory<uint64_t>. Bits past Size() in the last
+// word are kept zero, so the word-parallel kernels never have to mask them
+class BitVector {
+    using Growth = DefaultGrowth;
+
+    static constexpr size_t WORD_BITS = 64;
+
+public:
+    // Proxy returned by operator[]
+    class Reference {
+    public:
+        Reference(uint64_t& word, uint64_t mask) noexcept
+            : word_(word)
+            , mask_(mask) {
+        }
+
+        operator bool() const noexcept {
+            return (word_ & mask_) != 0;
+        }
+
+        Reference& operator=(bool value) noexcept {
+            word_ = value ? word_ | mask_ : word_ & ~mask_;
+            return *this;
+        }
+
+        Reference& operator=(const Reference& other) noexcept {
+            return *this = static_cast<bool>(other);
+        }
+
+        void Flip() noexcept {
+            word_ ^= mask_;
+        }
+
+    private:
+        uint64_t& word_;
+        uint64_t mask_;
+    };
+
+    BitVector() = default;
+
+    explicit BitVector(size_t size, bool value = false) {
+        Resize(size, value);
+    }
+
+    BitVector(const BitVector& other)
+        : words_(WordsFor(other.size_))
+        , size_(other.size_) {
+        std::copy_n(other.words_.GetAddress(), WordsFor(size_), words_.GetAddress());
+    }
+
+    BitVector(BitVector&& other) noexcept {
+        Swap(other);
+    }
+
+    BitVector& operator=(const BitVector& rhs) {
+        if (this != &rhs) {
+            if (WordsFor(rhs.size_) > words_.Capacity()) {
+                BitVector copy(rhs);
+                Swap(copy);
+            }
+            else {
+                std::copy_n(rhs.words_.GetAddress(), WordsFor(rhs.size_), words_.GetAddress());
+                size_ = rhs.size_;
+            }
+        }
+        return *this;
+    }
+
+    BitVector& operator=(BitVector&& rhs) noexcept {
+        Swap(rhs);
+        return *this;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return words_.Capacity() * WORD_BITS;
+    }
+
+    void Swap(BitVector& other) noexcept {
+        words_.Swap(other.words_);
+        std::swap(size_, other.size_);
+    }
+
+    void Reserve(size_t new_capacity) {
+        const size_t num_words = WordsFor(new_capacity);
+        if (num_words > words_.Capacity()) {
+            RawMemory<uint64_t> new_words(num_words);
+            std::copy_n(words_.GetAddress(), WordsFor(size_), new_words.GetAddress());
+            words_.Swap(new_words);
+        }
+    }
+
+    void Resize(size_t new_size, bool value = false) {
+        if (new_size < size_) {
+            size_ = new_size;
+            ClearTail();
+            return;
+        }
+        if (WordsFor(new_size) > words_.Capacity()) {
+            Reserve(Growth::NextCapacity(words_.Capacity(), WordsFor(new_size), sizeof(uint64_t)) * WORD_BITS);
+        }
+        // Whole new words are written at once, the partial last word bit by bit
+        const size_t old_words = WordsFor(size_);
+        std::fill(words_.GetAddress() + old_words, words_.GetAddress() + WordsFor(new_size), value ? ~uint64_t{0} : 0);
+        if (value) {
+            for (size_t i = size_; i < std::min(new_size, old_words * WORD_BITS); ++i) {
+                words_[i / WORD_BITS] |= Mask(i);
+            }
+        }
+        size_ = new_size;
+        ClearTail();
+    }
+
+    void PushBack(bool value) {
+        if (size_ == Capacity()) {
+            Reserve(Growth::NextCapacity(words_.Capacity(), words_.Capacity() + 1, sizeof(uint64_t)) * WORD_BITS);
+        }
+        if (size_ % WORD_BITS == 0) {
+            words_[size_ / WORD_BITS] = 0;
+        }
+        if (value) {
+            words_[size_ / WORD_BITS] |= Mask(size_);
+        }
+        ++size_;
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        --size_;
+        ClearTail();
+    }
+
+    void Clear() noexcept {
+        size_ = 0;
+    }
+
+    bool operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return (words_[index / WORD_BITS] & Mask(index)) != 0;
+    }
+
+    Reference operator[](size_t index) noexcept {
+        assert(index < size_);
+        return Reference(words_[index / WORD_BITS], Mask(index));
+    }
+
+    // Sets every bit to value
+    void Fill(bool value) noexcept {
+        std::fill_n(words_.GetAddress(), WordsFor(size_), value ? ~uint64_t{0} : 0);
+        ClearTail();
+    }
+
+    // Number of set bits
+    size_t Count() const noexcept {
+        return detail::PopcountWords(words_.GetAddress(), WordsFor(size_));
+    }
+
+    // Index of the first set bit at or after from, or Size() if there is none
+    size_t FindFirst(size_t from = 0) const noexcept {
+        if (from >= size_) {
+            return size_;
+        }
+        size_t word = from / WORD_BITS;
+        uint64_t bits = words_[word] & (~uint64_t{0} << from % WORD_BITS);
+        const size_t num_words = WordsFor(size_);
+        while (bits == 0) {
+            if (++word == num_words) {
+                return size_;
+            }
+            bits = words_[word];
+        }
+        return word * WORD_BITS + static_cast<size_t>(__builtin_ctzll(bits));
+    }
+
+    // Word-parallel in-place operations with a vector of the same size
+    BitVector& And(const BitVector& other) {
+        return Combine(other, [](uint64_t lhs, uint64_t rhs) {
+            return lhs & rhs;
+        });
+    }
+
+    BitVector& Or(const BitVector& other) {
+        return Combine(other, [](uint64_t lhs, uint64_t rhs) {
+            return lhs | rhs;
+        });
+    }
+
+    BitVector& Xor(const BitVector& other) {
+        return Combine(other, [](uint64_t lhs, uint64_t rhs) {
+            return lhs ^ rhs;
+        });
+    }
+
+    // Raw words for custom kernels; bits past Size() must stay zero
+    const uint64_t* Words() const noexcept {
+        return words_.GetAddress();
+    }
+
+    friend bool operator==(const BitVector& lhs, const BitVector& rhs) noexcept {
+        return lhs.size_ == rhs.size_
+            && std::equal(lhs.words_.GetAddress(), lhs.words_.GetAddress() + WordsFor(lhs.size_),
+                          rhs.words_.GetAddress());
+    }
+
+    friend bool operator!=(const BitVector& lhs, const BitVector& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+private:
+    static size_t WordsFor(size_t bits) noexcept {
+        return (bits + WORD_BITS - 1) / WORD_BITS;
+    }
+
+    static uint64_t Mask(size_t index) noexcept {
+        return uint64_t{1} << index % WORD_BITS;
+    }
+
+    void ClearTail() noexcept {
+        if (size_ % WORD_BITS != 0) {
+            words_[size_ / WORD_BITS] &= Mask(size_) - 1;
+        }
+    }
+
+    template <typename Operation>
+    BitVector& Combine(const BitVector& other, Operation op) {
+        if (other.size_ != size_) {
+            throw std::invalid_argument("bit vectors differ in size");
+        }
+        uint64_t* words = words_.GetAddress();
+        const uint64_t* other_words = other.words_.GetAddress();
+        const size_t num_words = WordsFor(size_);
+        for (size_t i = 0; i < num_words; ++i) {
+            words[i] = op(words[i], other_words[i]);
+        }
+        return *this;
+    }
+
+    RawMemory<uint64_t> words_;
+    size_t size_ = 0;
+};
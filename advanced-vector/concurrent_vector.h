@@ -0,0 +1,325 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <utility>
+
+// Vector that many threads can append to at once. Elements live in RawMemory segments of
+// doubling size, so growing never relocates them and references stay valid. A slot is
+// claimed with a single atomic increment; segments are installed with compare-and-swap.
+//
+// Reading an element is safe once the PushBack/EmplaceBack/GrowBy that created it has
+// returned and its result was published to the reader. Compact, Clear and destruction
+// must not run concurrently with anything else
+template <typename T>
+class ConcurrentVector {
+    static constexpr size_t FIRST_SEGMENT_SIZE = 16;
+    static constexpr size_t MAX_SEGMENTS = sizeof(size_t) * 8 - 4;
+
+    template <bool IsConst>
+    class Iterator {
+        using Owner = std::conditional_t<IsConst, const ConcurrentVector, ConcurrentVector>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Iterator() = default;
+
+        Iterator(Owner* owner, size_t index) noexcept
+            : owner_(owner)
+            , index_(index) {
+        }
+
+        reference operator*() const noexcept {
+            return (*owner_)[index_];
+        }
+
+        pointer operator->() const noexcept {
+            return &(*owner_)[index_];
+        }
+
+        reference operator[](difference_type offset) const noexcept {
+            return (*owner_)[index_ + offset];
+        }
+
+        Iterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept {
+            Iterator old = *this;
+            ++index_;
+            return old;
+        }
+
+        Iterator& operator--() noexcept {
+            --index_;
+            return *this;
+        }
+
+        Iterator operator--(int) noexcept {
+            Iterator old = *this;
+            --index_;
+            return old;
+        }
+
+        Iterator& operator+=(difference_type offset) noexcept {
+            index_ += offset;
+            return *this;
+        }
+
+        Iterator& operator-=(difference_type offset) noexcept {
+            index_ -= offset;
+            return *this;
+        }
+
+        friend Iterator operator+(Iterator it, difference_type offset) noexcept {
+            return it += offset;
+        }
+
+        friend Iterator operator-(Iterator it, difference_type offset) noexcept {
+            return it -= offset;
+        }
+
+        friend difference_type operator-(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ == rhs.index_;
+        }
+
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ != rhs.index_;
+        }
+
+        friend bool operator<(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ < rhs.index_;
+        }
+
+    private:
+        Owner* owner_ = nullptr;
+        size_t index_ = 0;
+    };
+
+public:
+    using value_type = T;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    // Elements created by one GrowBy call
+    struct Range {
+        iterator first;
+        iterator last;
+
+        iterator begin() const noexcept {
+            return first;
+        }
+
+        iterator end() const noexcept {
+            return last;
+        }
+    };
+
+    ConcurrentVector() = default;
+
+    ConcurrentVector(const ConcurrentVector&) = delete;
+    ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+    ~ConcurrentVector() {
+        Clear();
+    }
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    iterator end() noexcept {
+        return iterator(this, Size());
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, Size());
+    }
+
+    // Number of claimed slots, including ones whose construction is still in progress
+    size_t Size() const noexcept {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    T& PushBack(const T& value) {
+        return EmplaceBack(value);
+    }
+
+    T& PushBack(T&& value) {
+        return EmplaceBack(std::move(value));
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        const size_t index = size_.fetch_add(1, std::memory_order_relaxed);
+        try {
+            T* slot = Slot(index);
+            new(slot) T(std::forward<Args>(args)...);
+            return *slot;
+        }
+        catch (...) {
+            MarkFailed(index, index + 1);
+            throw;
+        }
+    }
+
+    // Appends count value-initialized elements and returns them
+    Range GrowBy(size_t count) {
+        const size_t first = size_.fetch_add(count, std::memory_order_relaxed);
+        size_t index = first;
+        try {
+            while (index != first + count) {
+                const size_t segment = SegmentOf(index);
+                const size_t chunk = std::min(first + count, SegmentStart(segment + 1)) - index;
+                std::uninitialized_value_construct_n(Slot(index), chunk);
+                index += chunk;
+            }
+        }
+        catch (...) {
+            MarkFailed(index, first + count);
+            throw;
+        }
+        return Range{ iterator(this, first), iterator(this, first + count) };
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<ConcurrentVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < Size());
+        const size_t segment = SegmentOf(index);
+        return segments_[segment].load(std::memory_order_acquire)[index - SegmentStart(segment)];
+    }
+
+    // Moves the constructed elements into a contiguous Vector and empties this one.
+    // Slots whose construction threw are skipped
+    Vector<T> Compact() {
+        Vector<T> result;
+        result.Reserve(Size());
+        ForEachRun([&result](T* first, size_t count) {
+            result.Append(std::make_move_iterator(first), std::make_move_iterator(first + count));
+        });
+        Clear();
+        return result;
+    }
+
+    // Destroys the elements keeping the allocated segments
+    void Clear() noexcept {
+        ForEachRun([](T* first, size_t count) {
+            std::destroy_n(first, count);
+        });
+        size_.store(0, std::memory_order_relaxed);
+        failed_.Clear();
+    }
+
+private:
+    static size_t SegmentOf(size_t index) noexcept {
+        size_t slot = index / FIRST_SEGMENT_SIZE + 1;
+        size_t segment = 0;
+        while (slot >>= 1) {
+            ++segment;
+        }
+        return segment;
+    }
+
+    static size_t SegmentStart(size_t segment) noexcept {
+        return FIRST_SEGMENT_SIZE * ((size_t{1} << segment) - 1);
+    }
+
+    static size_t SegmentSize(size_t segment) noexcept {
+        return FIRST_SEGMENT_SIZE << segment;
+    }
+
+    T* Slot(size_t index) {
+        const size_t segment = SegmentOf(index);
+        return Segment(segment) + (index - SegmentStart(segment));
+    }
+
+    // Returns the segment allocating it first if needed. Threads racing to allocate
+    // the same segment agree on one block; the losers free theirs
+    T* Segment(size_t segment) {
+        assert(segment < MAX_SEGMENTS);
+        T* address = segments_[segment].load(std::memory_order_acquire);
+        if (address != nullptr) {
+            return address;
+        }
+        RawMemory<T> block(SegmentSize(segment));
+        if (segments_[segment].compare_exchange_strong(address, block.GetAddress(), std::memory_order_acq_rel,
+                                                       std::memory_order_acquire)) {
+            address = block.GetAddress();
+            blocks_[segment] = std::move(block);
+        }
+        return address;
+    }
+
+    // Failures are rare, so they are recorded under a mutex
+    void MarkFailed(size_t first, size_t last) noexcept {
+        std::lock_guard lock(failed_mutex_);
+        try {
+            failed_.EmplaceBack(first, last);
+        }
+        catch (...) {
+            // Without the record the slots cannot be told apart from live elements
+            std::terminate();
+        }
+    }
+
+    bool IsFailed(size_t index) const noexcept {
+        return std::any_of(failed_.begin(), failed_.end(), [index](const std::pair<size_t, size_t>& range) {
+            return range.first <= index && index < range.second;
+        });
+    }
+
+    // Calls op(first, count) for every run of constructed elements that shares a segment
+    template <typename Operation>
+    void ForEachRun(Operation op) {
+        const size_t size = Size();
+        size_t index = 0;
+        while (index < size) {
+            const size_t segment = SegmentOf(index);
+            const size_t segment_end = std::min(size, SegmentStart(segment + 1));
+            const size_t segment_start = SegmentStart(segment);
+            T* data = segments_[segment].load(std::memory_order_acquire);
+            while (index < segment_end) {
+                if (IsFailed(index)) {
+                    ++index;
+                    continue;
+                }
+                size_t run_end = index + 1;
+                while (run_end < segment_end && !IsFailed(run_end)) {
+                    ++run_end;
+                }
+                op(data + (index - segment_start), run_end - index);
+                index = run_end;
+            }
+        }
+    }
+
+    std::atomic<size_t> size_ = 0;
+    std::atomic<T*> segments_[MAX_SEGMENTS] = {};
+    RawMemory<T> blocks_[MAX_SEGMENTS];
+    std::mutex failed_mutex_;
+    Vector<std::pair<size_t, size_t>> failed_;
+};
@@ -0,0 +1,194 @@
+#pragma once
+#include "flat_set.h"
+#include "vector.h"
+
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Sorted map keeping its keys and values in two parallel Vectors, so a lookup binary-searches
+// a buffer holding nothing but keys. Entry i is (KeyAt(i), ValueAt(i)) in key order
+template <typename K, typename V, typename Compare = std::less<K>>
+class FlatMap {
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using key_compare = Compare;
+
+    FlatMap() = default;
+
+    explicit FlatMap(const Compare& less)
+        : less_(less) {
+    }
+
+    size_t Size() const noexcept {
+        return keys_.Size();
+    }
+
+    void Reserve(size_t new_capacity) {
+        keys_.Reserve(new_capacity);
+        values_.Reserve(new_capacity);
+    }
+
+    void Clear() noexcept {
+        keys_.Clear();
+        values_.Clear();
+    }
+
+    bool Contains(const K& key) const {
+        return FindIndex(key) != keys_.Size();
+    }
+
+    // Returns the value of key, or nullptr if there is none
+    V* Find(const K& key) {
+        const size_t index = FindIndex(key);
+        return index != keys_.Size() ? &values_[index] : nullptr;
+    }
+
+    const V* Find(const K& key) const {
+        return const_cast<FlatMap&>(*this).Find(key);
+    }
+
+    V& At(const K& key) {
+        if (V* value = Find(key)) {
+            return *value;
+        }
+        throw std::out_of_range("key is not in the map");
+    }
+
+    const V& At(const K& key) const {
+        return const_cast<FlatMap&>(*this).At(key);
+    }
+
+    // Inserts a value-initialized entry when key is missing
+    V& operator[](const K& key) {
+        return *Emplace(key).first;
+    }
+
+    // Returns the value of key and whether it was inserted; an existing value is kept
+    template <typename Key, typename... Args>
+    std::pair<V*, bool> Emplace(Key&& key, Args&&... args) {
+        const size_t index = LowerBoundIndex(key);
+        if (index != keys_.Size() && !less_(key, keys_[index])) {
+            return { &values_[index], false };
+        }
+        keys_.Insert(keys_.begin() + index, std::forward<Key>(key));
+        try {
+            values_.Emplace(values_.begin() + index, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            keys_.Erase(keys_.begin() + index);
+            throw;
+        }
+        return { &values_[index], true };
+    }
+
+    std::pair<V*, bool> Insert(const K& key, const V& value) {
+        return Emplace(key, value);
+    }
+
+    std::pair<V*, bool> Insert(K&& key, V&& value) {
+        return Emplace(std::move(key), std::move(value));
+    }
+
+    // Inserts the (key, value) pairs of [first, last): they are appended, sorted and merged
+    // with the old entries, and duplicates are dropped. Existing entries win over new ones,
+    // and among new ones the first wins. If anything throws, the map is left as it was
+    template <typename InputIt>
+    void InsertRange(InputIt first, InputIt last) {
+        const size_t old_size = keys_.Size();
+        try {
+            for (; first != last; ++first) {
+                const auto& [key, value] = *first;
+                EmplaceBackEntry(key, value);
+            }
+            if (keys_.Size() == old_size) {
+                return;
+            }
+            // The merge is done on entry indices and then applied to both vectors
+            const Vector<size_t> order = detail::MergedOrder(keys_.Data(), old_size, keys_.Size(), less_);
+            Vector<K> keys;
+            Vector<V> values;
+            keys.Reserve(order.Size());
+            values.Reserve(order.Size());
+            // A gather that moves cannot fail, so it runs last: an exception from the other
+            // one then leaves both vectors intact
+            if constexpr (std::is_nothrow_move_constructible_v<K>) {
+                detail::GatherInto(values_, order, values);
+                detail::GatherInto(keys_, order, keys);
+            }
+            else {
+                detail::GatherInto(keys_, order, keys);
+                detail::GatherInto(values_, order, values);
+            }
+            keys_.Swap(keys);
+            values_.Swap(values);
+        }
+        catch (...) {
+            keys_.Erase(keys_.begin() + old_size, keys_.end());
+            values_.Erase(values_.begin() + old_size, values_.end());
+            throw;
+        }
+    }
+
+    // Returns the number of entries removed (0 or 1)
+    size_t Erase(const K& key) {
+        const size_t index = FindIndex(key);
+        if (index == keys_.Size()) {
+            return 0;
+        }
+        keys_.Erase(keys_.begin() + index);
+        values_.Erase(values_.begin() + index);
+        return 1;
+    }
+
+    const K& KeyAt(size_t index) const noexcept {
+        return keys_[index];
+    }
+
+    V& ValueAt(size_t index) noexcept {
+        return values_[index];
+    }
+
+    const V& ValueAt(size_t index) const noexcept {
+        return values_[index];
+    }
+
+    // Sorted keys and the values in the same order, for bulk reads
+    const Vector<K>& Keys() const noexcept {
+        return keys_;
+    }
+
+    const Vector<V>& Values() const noexcept {
+        return values_;
+    }
+
+private:
+    size_t LowerBoundIndex(const K& key) const {
+        return detail::BranchlessLowerBound(keys_.Data(), keys_.Size(), key, less_);
+    }
+
+    // Index of key, or Size() if it is missing
+    size_t FindIndex(const K& key) const {
+        const size_t index = LowerBoundIndex(key);
+        return index != keys_.Size() && !less_(key, keys_[index]) ? index : keys_.Size();
+    }
+
+    template <typename Key, typename Value>
+    void EmplaceBackEntry(Key&& key, Value&& value) {
+        keys_.EmplaceBack(std::forward<Key>(key));
+        try {
+            values_.EmplaceBack(std::forward<Value>(value));
+        }
+        catch (...) {
+            keys_.PopBack();
+            throw;
+        }
+    }
+
+    Vector<K> keys_;
+    Vector<V> values_;
+    Compare less_;
+};
@@ -0,0 +1,192 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <utility>
+
+namespace detail {
+
+// Index of the first of the size sorted keys that is not less than key. The loop has a fixed
+// trip count of log2(size) and the comparison only selects the next base, which compilers
+// turn into a conditional move instead of a hard-to-predict branch
+template <typename K, typename Compare>
+size_t BranchlessLowerBound(const K* keys, size_t size, const K& key, const Compare& less) {
+    const K* base = keys;
+    while (size > 1) {
+        const size_t half = size / 2;
+        base = less(base[half], key) ? base + half : base;
+        size -= half;
+    }
+    return static_cast<size_t>(base - keys) + (size == 1 && less(*base, key) ? 1 : 0);
+}
+
+// Indices of the size keys in sorted order with duplicates dropped, where the first
+// old_size keys are already sorted and unique. Among equal keys the one with the lowest
+// index is kept, so old keys win over new ones. Only compares keys, so if the comparison
+// throws the keys are left untouched
+template <typename K, typename Compare>
+Vector<size_t> MergedOrder(const K* keys, size_t old_size, size_t size, const Compare& less) {
+    Vector<size_t> order(size);
+    std::iota(order.begin(), order.end(), size_t{0});
+    const auto by_key = [keys, &less](size_t lhs, size_t rhs) {
+        return less(keys[lhs], keys[rhs]);
+    };
+    std::stable_sort(order.begin() + old_size, order.end(), by_key);
+    std::inplace_merge(order.begin(), order.begin() + old_size, order.end(), by_key);
+    const auto unique_end = std::unique(order.begin(), order.end(), [keys, &less](size_t lhs, size_t rhs) {
+        return !less(keys[lhs], keys[rhs]);
+    });
+    order.Erase(unique_end, order.end());
+    return order;
+}
+
+// Appends the elements of source at the indices in order to result, which must already have
+// the capacity for them. Elements are moved only if that cannot throw, so a failure leaves
+// source holding every element, and with nothrow moves nothing can fail
+template <typename T>
+void GatherInto(Vector<T>& source, const Vector<size_t>& order, Vector<T>& result) {
+    assert(result.Capacity() - result.Size() >= order.Size());
+    for (const size_t index : order) {
+        result.EmplaceBack(std::move_if_noexcept(source[index]));
+    }
+}
+
+}  // namespace detail
+
+// Sorted set of unique keys stored contiguously in a Vector. Lookups are binary searches over
+// one buffer; Insert and Erase shift the tail, so it suits small or read-mostly sets
+template <typename K, typename Compare = std::less<K>>
+class FlatSet {
+public:
+    using value_type = K;
+    using key_compare = Compare;
+    using const_iterator = typename Vector<K>::const_iterator;
+    using iterator = const_iterator;
+
+    FlatSet() = default;
+
+    explicit FlatSet(const Compare& less)
+        : less_(less) {
+    }
+
+    template <typename InputIt, typename = std::enable_if_t<detail::IsInputIterator<InputIt>::value>>
+    FlatSet(InputIt first, InputIt last, const Compare& less = Compare())
+        : less_(less) {
+        InsertRange(first, last);
+    }
+
+    const_iterator begin() const noexcept {
+        return keys_.begin();
+    }
+
+    const_iterator end() const noexcept {
+        return keys_.end();
+    }
+
+    size_t Size() const noexcept {
+        return keys_.Size();
+    }
+
+    void Reserve(size_t new_capacity) {
+        keys_.Reserve(new_capacity);
+    }
+
+    void Clear() noexcept {
+        keys_.Clear();
+    }
+
+    bool Contains(const K& key) const {
+        const size_t index = LowerBoundIndex(key);
+        return index != keys_.Size() && !less_(key, keys_[index]);
+    }
+
+    const_iterator Find(const K& key) const {
+        const size_t index = LowerBoundIndex(key);
+        return index != keys_.Size() && !less_(key, keys_[index]) ? begin() + index : end();
+    }
+
+    const_iterator LowerBound(const K& key) const {
+        return begin() + LowerBoundIndex(key);
+    }
+
+    // Returns the position of key and whether it was inserted
+    std::pair<const_iterator, bool> Insert(const K& key) {
+        return Emplace(key);
+    }
+
+    std::pair<const_iterator, bool> Insert(K&& key) {
+        return Emplace(std::move(key));
+    }
+
+    // Appends the keys, sorts the new tail and merges it with the old keys, keeping an
+    // existing key over an equal new one. For k new keys this costs O(k log k + n) instead of
+    // k shifting inserts. If anything throws, the set is left as it was
+    template <typename InputIt>
+    void InsertRange(InputIt first, InputIt last) {
+        const size_t old_size = keys_.Size();
+        try {
+            keys_.Append(first, last);
+            if (keys_.Size() == old_size) {
+                return;
+            }
+            const Vector<size_t> order = detail::MergedOrder(keys_.Data(), old_size, keys_.Size(), less_);
+            Vector<K> merged;
+            merged.Reserve(order.Size());
+            detail::GatherInto(keys_, order, merged);
+            keys_.Swap(merged);
+        }
+        catch (...) {
+            keys_.Erase(keys_.begin() + old_size, keys_.end());
+            throw;
+        }
+    }
+
+    // Returns the number of keys removed (0 or 1)
+    size_t Erase(const K& key) {
+        const const_iterator pos = Find(key);
+        if (pos == end()) {
+            return 0;
+        }
+        keys_.Erase(pos);
+        return 1;
+    }
+
+    const_iterator Erase(const_iterator pos) {
+        return keys_.Erase(pos);
+    }
+
+    // Sorted keys, for bulk reads
+    const Vector<K>& Keys() const noexcept {
+        return keys_;
+    }
+
+    friend bool operator==(const FlatSet& lhs, const FlatSet& rhs) {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+    friend bool operator!=(const FlatSet& lhs, const FlatSet& rhs) {
+        return !(lhs == rhs);
+    }
+
+private:
+    size_t LowerBoundIndex(const K& key) const {
+        return detail::BranchlessLowerBound(keys_.Data(), keys_.Size(), key, less_);
+    }
+
+    template <typename Key>
+    std::pair<const_iterator, bool> Emplace(Key&& key) {
+        const size_t index = LowerBoundIndex(key);
+        if (index != keys_.Size() && !less_(key, keys_[index])) {
+            return { begin() + index, false };
+        }
+        return { keys_.Insert(keys_.begin() + index, std::forward<Key>(key)), true };
+    }
+
+    Vector<K> keys_;
+    Compare less_;
+};
@@ -0,0 +1,280 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace detail {
+
+// Smallest unsigned type that can count to N
+template <size_t N>
+using SmallestSize = std::conditional_t<
+    N <= UINT8_MAX, uint8_t,
+    std::conditional_t<N <= UINT16_MAX, uint16_t, std::conditional_t<N <= UINT32_MAX, uint32_t, size_t>>>;
+
+// Inline buffer and size of an InplaceVector. For trivially copyable T the special members
+// are the implicit ones, so the whole vector stays trivially copyable
+template <typename T, size_t N, bool = std::is_trivially_copyable_v<T>>
+class InplaceStorage {
+protected:
+    T* Data() noexcept {
+        return reinterpret_cast<T*>(buffer_);
+    }
+
+    const T* Data() const noexcept {
+        return reinterpret_cast<const T*>(buffer_);
+    }
+
+    alignas(T) std::byte buffer_[N * sizeof(T)];
+    SmallestSize<N> size_ = 0;
+};
+
+template <typename T, size_t N>
+class InplaceStorage<T, N, false> {
+public:
+    InplaceStorage() = default;
+
+    InplaceStorage(const InplaceStorage& other) {
+        std::uninitialized_copy_n(other.Data(), other.size_, Data());
+        size_ = other.size_;
+    }
+
+    // The source is left empty, as a moved-from Vector is
+    InplaceStorage(InplaceStorage&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        std::uninitialized_move_n(other.Data(), other.size_, Data());
+        size_ = other.size_;
+        other.Clear();
+    }
+
+    InplaceStorage& operator=(const InplaceStorage& rhs) {
+        if (this != &rhs) {
+            detail::AssignWithinCapacity(Data(), size_, rhs.Data(), rhs.size_);
+            size_ = rhs.size_;
+        }
+        return *this;
+    }
+
+    InplaceStorage& operator=(InplaceStorage&& rhs) noexcept(std::is_nothrow_move_assignable_v<T>
+                                                             && std::is_nothrow_move_constructible_v<T>) {
+        if (this != &rhs) {
+            const size_t common = std::min<size_t>(size_, rhs.size_);
+            std::move(rhs.Data(), rhs.Data() + common, Data());
+            if (rhs.size_ < size_) {
+                std::destroy(Data() + common, Data() + size_);
+            }
+            else {
+                std::uninitialized_move(rhs.Data() + common, rhs.Data() + rhs.size_, Data() + common);
+            }
+            size_ = rhs.size_;
+            rhs.Clear();
+        }
+        return *this;
+    }
+
+    ~InplaceStorage() {
+        Clear();
+    }
+
+protected:
+    T* Data() noexcept {
+        return reinterpret_cast<T*>(buffer_);
+    }
+
+    const T* Data() const noexcept {
+        return reinterpret_cast<const T*>(buffer_);
+    }
+
+    void Clear() noexcept {
+        std::destroy_n(Data(), size_);
+        size_ = 0;
+    }
+
+    alignas(T) std::byte buffer_[N * sizeof(T)];
+    SmallestSize<N> size_ = 0;
+};
+
+}  // namespace detail
+
+// Vector with a fixed capacity of N elements stored inline; it never allocates. Appending
+// to a full vector throws std::bad_alloc, as if an allocation had failed, while the Try
+// functions report it by their return value. Insertion and erasure share Vector's element
+// code and exception guarantees, and the size is kept in the smallest type that holds N
+template <typename T, size_t N>
+class InplaceVector : private detail::InplaceStorage<T, N> {
+    static_assert(N > 0, "capacity must not be zero");
+
+    using Storage = detail::InplaceStorage<T, N>;
+    using Storage::Data;
+    using Storage::size_;
+
+public:
+    using value_type = T;
+    using size_type = detail::SmallestSize<N>;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr size_t CAPACITY = N;
+
+    iterator begin() noexcept {
+        return Data();
+    }
+
+    iterator end() noexcept {
+        return Data() + size_;
+    }
+
+    const_iterator begin() const noexcept {
+        return Data();
+    }
+
+    const_iterator end() const noexcept {
+        return Data() + size_;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return Data();
+    }
+
+    const_iterator cend() const noexcept {
+        return Data() + size_;
+    }
+
+    InplaceVector() = default;
+
+    explicit InplaceVector(size_t size) {
+        Resize(size);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    static constexpr size_t Capacity() noexcept {
+        return N;
+    }
+
+    bool IsFull() const noexcept {
+        return size_ == N;
+    }
+
+    void Swap(InplaceVector& other) noexcept(std::is_nothrow_move_constructible_v<T>
+                                             && std::is_nothrow_move_assignable_v<T>) {
+        InplaceVector temp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(temp);
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size > N) {
+            throw std::bad_alloc();
+        }
+        if (new_size < size_) {
+            std::destroy_n(Data() + new_size, size_ - new_size);
+        }
+        else if (new_size > size_) {
+            std::uninitialized_value_construct_n(Data() + size_, new_size - size_);
+        }
+        size_ = static_cast<size_type>(new_size);
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        T* elem = TryEmplaceBack(std::forward<Args>(args)...);
+        if (elem == nullptr) {
+            throw std::bad_alloc();
+        }
+        return *elem;
+    }
+
+    // Returns false and leaves the vector unchanged when it is full
+    bool TryPushBack(const T& value) {
+        return TryEmplaceBack(value) != nullptr;
+    }
+
+    bool TryPushBack(T&& value) {
+        return TryEmplaceBack(std::move(value)) != nullptr;
+    }
+
+    // Returns the new element, or nullptr without touching args when the vector is full
+    template <typename... Args>
+    T* TryEmplaceBack(Args&&... args) {
+        if (size_ == N) {
+            return nullptr;
+        }
+        T* elem = new(Data() + size_) T(std::forward<Args>(args)...);
+        ++size_;
+        return elem;
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        --size_;
+        std::destroy_at(Data() + size_);
+    }
+
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        if (size_ == N) {
+            throw std::bad_alloc();
+        }
+        if (pos == end()) {
+            return &EmplaceBack(std::forward<Args>(args)...);
+        }
+        size_t index = static_cast<size_t>(pos - begin());
+        detail::EmplaceShifting(Data(), size_, index, std::forward<Args>(args)...);
+        ++size_;
+        return begin() + index;
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    iterator Erase(const_iterator pos) noexcept(std::is_nothrow_move_assignable_v<T>) {
+        return Erase(pos, pos + 1);
+    }
+
+    iterator Erase(const_iterator first, const_iterator last) noexcept(std::is_nothrow_move_assignable_v<T>) {
+        size_t index = static_cast<size_t>(first - begin());
+        size_t count = static_cast<size_t>(last - first);
+        assert(index + count <= size_);
+        if (count != 0) {
+            detail::EraseShifting(Data(), size_, index, count);
+            size_ -= static_cast<size_type>(count);
+        }
+        return begin() + index;
+    }
+
+    void Clear() noexcept {
+        std::destroy_n(Data(), size_);
+        size_ = 0;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return Data()[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return Data()[index];
+    }
+};
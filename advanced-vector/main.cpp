@@ -1,121 +1,48 @@
+#include "aligned_allocator.h"
+#include "bit_vector.h"
+#include "concurrent_vector.h"
+#include "flat_map.h"
+#include "flat_set.h"
+#include "inplace_vector.h"
+#include "mapped_vector.h"
+#include "page_allocator.h"
+#include "pool_allocator.h"
+#include "realloc_allocator.h"
+#include "segmented_vector.h"
+#include "shared_vector.h"
+#include "small_vector.h"
+#include "soa_vector.h"
+#include "test_types.h"
 #include "vector.h"
+#include "vector_io.h"
+#include "vector_ops.h"
+#include "vector_profile.h"
+#include "vector_sink.h"
+#include "vector_stats.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <memory_resource>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
-namespace {
-
-    inline const uint32_t DEFAULT_COOKIE = 0xdeadbeef;
-
-    struct TestObj {
-        TestObj() = default;
-        TestObj(const TestObj& other) = default;
-        TestObj& operator=(const TestObj& other) = default;
-        TestObj(TestObj&& other) = default;
-        TestObj& operator=(TestObj&& other) = default;
-        ~TestObj() {
-            cookie = 0;
-        }
-        [[nodiscard]] bool IsAlive() const noexcept {
-            return cookie == DEFAULT_COOKIE;
-        }
-        uint32_t cookie = DEFAULT_COOKIE;
-    };
-
-    struct Obj {
-        Obj() {
-            if (default_construction_throw_countdown > 0) {
-                if (--default_construction_throw_countdown == 0) {
-                    throw std::runtime_error("Oops");
-                }
-            }
-            ++num_default_constructed;
-        }
-
-        explicit Obj(int id)
-            : id(id)  //
-        {
-            ++num_constructed_with_id;
-        }
-
-        Obj(int id, std::string name)
-            : id(id)
-            , name(std::move(name))  //
-        {
-            ++num_constructed_with_id_and_name;
-        }
-
-        Obj(const Obj& other)
-            : id(other.id)  //
-        {
-            if (other.throw_on_copy) {
-                throw std::runtime_error("Oops");
-            }
-            ++num_copied;
-        }
-
-        Obj(Obj&& other) noexcept
-            : id(other.id)  //
-        {
-            ++num_moved;
-        }
-
-        Obj& operator=(const Obj& other) {
-            if (this != &other) {
-                id = other.id;
-                name = other.name;
-                ++num_assigned;
-            }
-            return *this;
-        }
-
-        Obj& operator=(Obj&& other) noexcept {
-            id = other.id;
-            name = std::move(other.name);
-            ++num_move_assigned;
-            return *this;
-        }
-
-        ~Obj() {
-            ++num_destroyed;
-            id = 0;
-        }
-
-        static int GetAliveObjectCount() {
-            return num_default_constructed + num_copied + num_moved + num_constructed_with_id
-                + num_constructed_with_id_and_name - num_destroyed;
-        }
-
-        static void ResetCounters() {
-            default_construction_throw_countdown = 0;
-            num_default_constructed = 0;
-            num_copied = 0;
-            num_moved = 0;
-            num_destroyed = 0;
-            num_constructed_with_id = 0;
-            num_constructed_with_id_and_name = 0;
-            num_assigned = 0;
-            num_move_assigned = 0;
-        }
-
-        bool throw_on_copy = false;
-        int id = 0;
-        std::string name;
-
-        static inline int default_construction_throw_countdown = 0;
-        static inline int num_default_constructed = 0;
-        static inline int num_constructed_with_id = 0;
-        static inline int num_constructed_with_id_and_name = 0;
-        static inline int num_copied = 0;
-        static inline int num_moved = 0;
-        static inline int num_destroyed = 0;
-        static inline int num_assigned = 0;
-        static inline int num_move_assigned = 0;
-    };
-
-}  // namespace
+#include <linux/mempolicy.h>
+#if VECTOR_ANNOTATE_CONTAINER
+#include <sanitizer/asan_interface.h>
+#endif
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 void Test1() {
     Obj::ResetCounters();
@@ -394,6 +321,19 @@ void Test5() {
         assert(v[0].IsAlive());
         assert(v[1].IsAlive());
     }
+    {
+        Vector<ThrowingCopy> v(2);
+        v[1].throw_on_copy = true;
+        try {
+            v.EmplaceBack();
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 2 && v.Capacity() == 2);
+        assert(ThrowingCopy::num_alive == 2);
+    }
+    assert(ThrowingCopy::num_alive == 0);
 }
 
 void Test6() {
@@ -430,7 +370,7 @@ void Test6() {
     {
         Obj::ResetCounters();
         Vector<Obj> v;
-        auto* pos = v.Emplace(v.end(), Obj{ 1 });
+        auto pos = v.Emplace(v.end(), Obj{ 1 });
         assert(v.Size() == 1);
         assert(v.Capacity() >= v.Size());
         assert(&*pos == &v[0]);
@@ -445,7 +385,7 @@ void Test6() {
         Obj::ResetCounters();
         Vector<Obj> v;
         v.Reserve(SIZE);
-        auto* pos = v.Emplace(v.end(), Obj{ 1 });
+        auto pos = v.Emplace(v.end(), Obj{ 1 });
         assert(v.Size() == 1);
         assert(v.Capacity() >= v.Size());
         assert(&*pos == &v[0]);
@@ -492,7 +432,7 @@ void Test6() {
     {
         Obj::ResetCounters();
         Vector<Obj> v{ SIZE };
-        auto* pos = v.Emplace(v.cbegin() + 1, ID, "Ivan"s);
+        auto pos = v.Emplace(v.cbegin() + 1, ID, "Ivan"s);
         assert(v.Size() == SIZE + 1);
         assert(v.Capacity() == SIZE * 2);
         assert(&*pos == &v[1]);
@@ -508,7 +448,7 @@ void Test6() {
     {
         Obj::ResetCounters();
         Vector<Obj> v{ SIZE };
-        auto* pos = v.Emplace(v.cbegin() + v.Size(), ID, "Ivan"s);
+        auto pos = v.Emplace(v.cbegin() + v.Size(), ID, "Ivan"s);
         assert(v.Size() == SIZE + 1);
         assert(v.Capacity() == SIZE * 2);
         assert(&*pos == &v[SIZE]);
@@ -527,7 +467,7 @@ void Test6() {
         v.Reserve(SIZE * 2);
         const int old_num_moved = Obj::num_moved;
         assert(v.Capacity() == SIZE * 2);
-        auto* pos = v.Emplace(v.cbegin() + 3, ID, "Ivan"s);
+        auto pos = v.Emplace(v.cbegin() + 3, ID, "Ivan"s);
         assert(v.Size() == SIZE + 1);
         assert(&*pos == &v[3]);
         assert(v[3].id == ID);
@@ -543,7 +483,7 @@ void Test6() {
         Obj::ResetCounters();
         Vector<Obj> v{ SIZE };
         v[2].id = ID;
-        auto* pos = v.Erase(v.cbegin() + 1);
+        auto pos = v.Erase(v.cbegin() + 1);
         assert((pos - v.begin()) == 1);
         assert(v.Size() == SIZE - 1);
         assert(v.Capacity() == SIZE);
@@ -556,87 +496,1907 @@ void Test6() {
     }
 }
 
-struct C {
-    C() noexcept {
-        ++def_ctor;
+void Test7() {
+    const size_t SIZE = 100;
+    const int ID = 42;
+    {
+        std::byte buffer[4096];
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+        pmr::Vector<int> v(&arena);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        assert(v.Size() == SIZE);
+        assert(v.GetAllocator().resource() == &arena);
+        const auto* first = reinterpret_cast<const std::byte*>(&v[0]);
+        assert(first >= buffer && first < buffer + sizeof(buffer));
+
+        pmr::Vector<int> v_copy(v);
+        assert(v_copy.GetAllocator().resource() == std::pmr::get_default_resource());
+        assert(v_copy[SIZE - 1] == static_cast<int>(SIZE - 1));
+    }
+    {
+        Obj::ResetCounters();
+        std::pmr::unsynchronized_pool_resource first_pool;
+        std::pmr::unsynchronized_pool_resource second_pool;
+        pmr::Vector<Obj> v(SIZE, &first_pool);
+        v[0].id = ID;
+        pmr::Vector<Obj> same(&first_pool);
+        same = std::move(v);
+        assert(same.Size() == SIZE);
+        assert(Obj::num_moved == 0);
+
+        pmr::Vector<Obj> other(&second_pool);
+        other = std::move(same);
+        assert(other.Size() == SIZE);
+        assert(other.GetAllocator().resource() == &second_pool);
+        assert(other[0].id == ID);
+        assert(Obj::num_moved == static_cast<int>(SIZE));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // Elements are built through the allocator, so strings draw from the same arena
+        using namespace std::literals;
+        const std::pmr::string long_text(100, 'x');
+        std::byte buffer[16384];
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+        pmr::Vector<std::pmr::string> v(&arena);
+        v.EmplaceBack(long_text);
+        v.PushBack(std::pmr::string(long_text));
+        v.Emplace(v.cbegin() + 1, long_text);
+        v.Emplace(v.cbegin(), 5, 'y');
+        v.Insert(v.cbegin() + 2, 2, v[0]);
+        const std::vector<std::pmr::string> words = { long_text, long_text };
+        v.Insert(v.cbegin() + 1, words.begin(), words.end());
+        v.Resize(v.Size() + 3);
+        assert(v.Size() == 11 && v[0] == "yyyyy"sv && v[1] == long_text && v[10].empty());
+        for (const std::pmr::string& str : v) {
+            const auto* chars = reinterpret_cast<const std::byte*>(str.data());
+            assert(str.get_allocator().resource() == &arena);
+            assert(chars >= buffer && chars < buffer + sizeof(buffer));
+        }
+        v.Erase(v.cbegin());
+        v.PopBack();
+
+        pmr::Vector<std::pmr::string> copy(v, &arena);
+        assert(copy.Size() == v.Size() && copy[0] == long_text);
+        for (const std::pmr::string& str : copy) {
+            assert(str.get_allocator().resource() == &arena);
+        }
     }
-    C(const C& /*other*/) noexcept {
-        ++copy_ctor;
+}
+
+namespace {
+
+    struct RelocatableHandle {
+        explicit RelocatableHandle(int id)
+            : id(id) {
+        }
+        RelocatableHandle(const RelocatableHandle& other)
+            : id(other.id) {
+            ++num_copied;
+        }
+        RelocatableHandle(RelocatableHandle&& other) noexcept
+            : id(std::exchange(other.id, 0)) {
+            ++num_moved;
+        }
+        ~RelocatableHandle() {
+            id = 0;
+        }
+
+        int id = 0;
+
+        static inline int num_copied = 0;
+        static inline int num_moved = 0;
+    };
+
+}  // namespace
+
+template <>
+struct is_trivially_relocatable<RelocatableHandle> : std::true_type {
+};
+
+void Test8() {
+    const size_t SIZE = 1000;
+    {
+        static_assert(is_trivially_relocatable_v<int>);
+        static_assert(is_trivially_relocatable_v<std::unique_ptr<int>>);
+        static_assert(!is_trivially_relocatable_v<Obj>);
     }
-    C(C&& /*other*/) noexcept {
-        ++move_ctor;
+    {
+        Vector<std::unique_ptr<int>> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(std::make_unique<int>(static_cast<int>(i)));
+        }
+        v.Emplace(v.begin(), std::make_unique<int>(-1));
+        assert(v.Size() == SIZE + 1);
+        assert(*v[0] == -1);
+        assert(*v[SIZE] == static_cast<int>(SIZE - 1));
     }
-    C& operator=(const C& other) noexcept {
-        if (this != &other) {
-            ++copy_assign;
+    {
+        Vector<RelocatableHandle> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
         }
-        return *this;
+        v.Reserve(SIZE * 4);
+        assert(RelocatableHandle::num_moved == 0);
+        assert(RelocatableHandle::num_copied == 0);
+        assert(v[SIZE - 1].id == static_cast<int>(SIZE - 1));
+    }
+}
+
+void Test9() {
+    const size_t SIZE = 1'000'000;
+    {
+        static_assert(RawMemory<int, ReallocAllocator<int>>::CAN_REALLOCATE);
+        static_assert(!RawMemory<Obj, ReallocAllocator<Obj>>::CAN_REALLOCATE);
+        static_assert(!RawMemory<int>::CAN_REALLOCATE);
     }
-    C& operator=(C&& /*other*/) noexcept {
-        ++move_assign;
-        return *this;
+    {
+        Vector<int, ReallocAllocator<int>> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        assert(v.Size() == SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i] == static_cast<int>(i));
+        }
+        v.Reserve(SIZE * 4);
+        assert(v.Capacity() == SIZE * 4);
+        assert(v[SIZE - 1] == static_cast<int>(SIZE - 1));
     }
-    ~C() {
-        ++dtor;
+    {
+        Vector<int, ReallocAllocator<int>> v(1);
+        v[0] = 7;
+        v.PushBack(v[0]);
+        assert(v.Size() == 2 && v[1] == 7);
+        v.EmplaceBack(v[1]);
+        v.Emplace(v.cbegin() + 1, 9);
+        assert(v.Size() == 4 && v.Capacity() == 4);
+        assert(v[0] == 7 && v[1] == 9 && v[2] == 7 && v[3] == 7);
+        v.Emplace(v.cbegin(), v[3]);
+        assert(v.Size() == 5 && v.Capacity() == 8 && v[0] == 7);
     }
+}
 
-    static void Reset() {
-        def_ctor = 0;
-        copy_ctor = 0;
-        move_ctor = 0;
-        copy_assign = 0;
-        move_assign = 0;
-        dtor = 0;
+void Test10() {
+    {
+        Vector<int> v;
+        std::vector<size_t> capacities;
+        for (int i = 0; i < 9; ++i) {
+            v.PushBack(i);
+            capacities.push_back(v.Capacity());
+        }
+        assert((capacities == std::vector<size_t>{ 1, 2, 4, 4, 8, 8, 8, 8, 16 }));
+    }
+    {
+        Vector<int, std::allocator<int>, CompactGrowth> v;
+        v.PushBack(1);
+        assert(v.Capacity() == 16);
+        for (int i = 0; i < 16; ++i) {
+            v.EmplaceBack(i);
+        }
+        assert(v.Capacity() == 24);
+        v.Emplace(v.cbegin(), 0);
+        assert(v.Size() == 18);
+    }
+    {
+        const size_t HUGE_PAGE = size_t{2} << 20;
+        assert(HugePageGrowth::NextCapacity(0, 1, sizeof(int)) == 16);
+        assert(HugePageGrowth::NextCapacity(10, 11, 12) == 21);
+        assert(HugePageGrowth::NextCapacity(HUGE_PAGE, HUGE_PAGE + 1, 1) == HUGE_PAGE * 2);
+        assert(HugePageGrowth::NextCapacity(HUGE_PAGE + 1, HUGE_PAGE + 2, 1) == HUGE_PAGE * 3);
+        const size_t GIB = size_t{1} << 30;
+        assert(HugePageGrowth::NextCapacity(GIB * 4, GIB * 4 + 1, 1) == GIB * 5);
     }
+}
 
-    inline static size_t def_ctor = 0;
-    inline static size_t copy_ctor = 0;
-    inline static size_t move_ctor = 0;
-    inline static size_t copy_assign = 0;
-    inline static size_t move_assign = 0;
-    inline static size_t dtor = 0;
-};
+void Test11() {
+    const size_t SIZE = 100;
+    const int ID = 42;
+    {
+        Obj::ResetCounters();
+        SmallVector<Obj, 4> v;
+        assert(v.Capacity() == 4 && v.IsInline());
+        v.EmplaceBack(ID);
+        v.PushBack(Obj{ 1 });
+        v.Insert(v.cbegin(), Obj{ 2 });
+        assert(v.IsInline() && v.Size() == 3);
+        assert(v[0].id == 2 && v[1].id == ID && v[2].id == 1);
+        v.EmplaceBack(3);
+        v.Emplace(v.cbegin() + 1, 4);
+        assert(!v.IsInline());
+        assert(v.Size() == 5 && v.Capacity() == 8);
+        assert(v[0].id == 2 && v[1].id == 4 && v[2].id == ID && v[4].id == 3);
+        v.Erase(v.cbegin());
+        assert(v.Size() == 4 && v[0].id == 4);
+        assert(Obj::num_copied == 0);
+        assert(Obj::GetAliveObjectCount() == 4);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        Obj::default_construction_throw_countdown = SIZE / 2;
+        try {
+            SmallVector<Obj, 8> v(SIZE);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        SmallVector<Obj, 8> v(SIZE);
+        v[SIZE / 2].throw_on_copy = true;
+        try {
+            SmallVector<Obj, 8> v_copy(v);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+            assert(Obj::num_copied == SIZE / 2);
+        }
+        assert(Obj::GetAliveObjectCount() == SIZE);
+    }
+    {
+        Obj::ResetCounters();
+        SmallVector<Obj, 8> small(3);
+        small[2].id = ID;
+        SmallVector<Obj, 8> moved(std::move(small));
+        assert(moved.IsInline() && moved.Size() == 3 && moved[2].id == ID);
+        assert(small.Size() == 0);
+        SmallVector<Obj, 8> big(SIZE);
+        big.Resize(SIZE / 2);
+        moved.Swap(big);
+        assert(moved.Size() == SIZE / 2 && !moved.IsInline());
+        assert(big.Size() == 3 && big[2].id == ID);
+        big = moved;
+        assert(big.Size() == SIZE / 2 && big.Capacity() >= SIZE / 2);
+        moved.Reserve(SIZE * 2);
+        assert(moved.Capacity() == SIZE * 2);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        SmallVector<ThrowingCopy, 2> v(2);
+        v[1].throw_on_copy = true;
+        try {
+            v.EmplaceBack();
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.IsInline() && v.Size() == 2);
+        assert(ThrowingCopy::num_alive == 2);
+    }
+    assert(ThrowingCopy::num_alive == 0);
+}
 
-void Dump() {
-    using namespace std;
-    cerr << "Def ctors: "sv << C::def_ctor              //
-        << ", Copy ctors: "sv << C::copy_ctor          //
-        << ", Move ctors: "sv << C::move_ctor          //
-        << ", Copy assignments: "sv << C::copy_assign  //
-        << ", Move assignments: "sv << C::move_assign  //
-        << ", Dtors: "sv << C::dtor << endl;
+void Test12() {
+    using namespace std::literals;
+    const size_t SIZE = 100;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE, default_init);
+        assert(v.Size() == SIZE);
+        assert(Obj::num_default_constructed == SIZE);
+        v.ResizeDefaultInit(SIZE * 2);
+        assert(v.Size() == SIZE * 2 && v.Capacity() == SIZE * 2);
+        v.ResizeDefaultInit(SIZE / 2);
+        assert(Obj::GetAliveObjectCount() == SIZE / 2);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Vector<int> v(SIZE, default_init);
+        assert(v.Size() == SIZE);
+        v[SIZE - 1] = 1;
+        assert(v[SIZE - 1] == 1);
+    }
+    {
+        const std::string message = "payload"s;
+        Vector<char> v;
+        v.PushBack('>');
+        v.ResizeAndOverwrite(SIZE, [&message](char* data, size_t size) {
+            assert(size == SIZE);
+            return std::copy(message.begin(), message.end(), data + 1) - data;
+            });
+        assert(v.Size() == message.size() + 1);
+        assert(std::string(v.begin(), v.end()) == ">payload"s);
+        assert(v.Capacity() == SIZE);
+    }
 }
 
-void Benchmark() {
-    using namespace std;
-    try {
-        const size_t NUM = 10;
-        C c;
-        {
-            cerr << "std::vector:"sv << endl;
-            C::Reset();
-            vector<C> v(NUM);
-            Dump();
-            v.push_back(c);
+void Test13() {
+    const size_t SIZE = 10;
+    {
+        Obj::ResetCounters();
+        std::vector<Obj> batch;
+        for (int i = 1; i <= 5; ++i) {
+            batch.emplace_back(i);
         }
-        Dump();
+        Vector<Obj> v(SIZE);
+        const int old_num_copied = Obj::num_copied;
+        const int old_num_moved = Obj::num_moved;
+        auto pos = v.Insert(v.cbegin() + 2, batch.begin(), batch.end());
+        assert(pos == v.begin() + 2);
+        assert(v.Size() == SIZE + 5 && v.Capacity() == SIZE * 2);
+        assert(v[2].id == 1 && v[6].id == 5 && v[7].id == 0);
+        assert(Obj::num_copied - old_num_copied == 5);
+        assert(Obj::num_moved - old_num_moved == static_cast<int>(SIZE));
+
+        v.Insert(v.cbegin() + 1, batch.begin(), batch.begin() + 2);
+        assert(v[1].id == 1 && v[2].id == 2 && v[3].id == 0 && v[4].id == 1);
+        v.Insert(v.cend() - 1, batch.begin(), batch.end());
+        assert(v.Size() == SIZE + 12 && v[v.Size() - 2].id == 5);
+    }
+    {
+        Vector<int> v(SIZE);
+        v.Reserve(SIZE * 3);
+        v[0] = 7;
+        v.Insert(v.cbegin() + SIZE - 1, 5, v[0]);
+        assert(v.Size() == SIZE + 5);
+        assert(v[SIZE - 2] == 0 && v[SIZE - 1] == 7 && v[SIZE + 3] == 7 && v[SIZE + 4] == 0);
+        v.Insert(v.cbegin(), 3, v[SIZE]);
+        assert(v[0] == 7 && v[2] == 7 && v[3] == 7 && v[4] == 0);
+        assert(v.Capacity() == SIZE * 3);
     }
-    catch (...) {
+    {
+        Vector<TestObj> v(SIZE);
+        v.Insert(v.cbegin() + 1, 20, v[0]);
+        v.Insert(v.cbegin() + 1, 2, v[5]);
+        assert(v.Size() == SIZE + 22);
+        assert(std::all_of(v.begin(), v.end(), [](const TestObj& obj) {
+            return obj.IsAlive();
+            }));
     }
-    try {
-        const size_t NUM = 10;
-        C c;
-        {
-            cerr << "Vector:"sv << endl;
-            C::Reset();
-            Vector<C> v(NUM);
-            Dump();
-            v.PushBack(c);
+    {
+        const std::vector<int> numbers = { 1, 2, 3, 4 };
+        Vector<int> v(numbers.begin(), numbers.end());
+        assert(v.Size() == 4 && v.Capacity() == 4 && v[3] == 4);
+        v.Append(numbers);
+        assert(v.Size() == 8 && v[4] == 1);
+
+        std::istringstream input("5 6 7");
+        v.Insert(v.cbegin() + 1, std::istream_iterator<int>(input), std::istream_iterator<int>());
+        assert(v.Size() == 11);
+        assert(v[0] == 1 && v[1] == 5 && v[3] == 7 && v[4] == 2);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(3);
+        v[0].id = 7;
+        std::istringstream input("5 6 x");
+        input.exceptions(std::ios::failbit);
+        try {
+            v.Insert(v.cbegin() + 1, std::istream_iterator<int>(input), std::istream_iterator<int>());
+            assert(false && "Exception is expected");
+        }
+        catch (const std::ios::failure&) {
+        }
+        assert(v.Size() == 3 && v[0].id == 7 && v[1].id == 0 && v[2].id == 0);
+        assert(Obj::GetAliveObjectCount() == 3);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        std::vector<Obj> batch;
+        for (int i = 1; i <= 4; ++i) {
+            batch.emplace_back(i);
+        }
+        Vector<Obj> v;
+        v.Reserve(SIZE * 2);
+        for (int i = 0; i < 6; ++i) {
+            v.EmplaceBack(i);
+        }
+        auto check_unchanged = [&v] {
+            assert(v.Size() == 6 && v.Capacity() == SIZE * 2);
+            for (int i = 0; i < 6; ++i) {
+                assert(v[static_cast<size_t>(i)].id == i);
+            }
+        };
+        Obj::copy_construction_throw_countdown = 3;
+        try {
+            v.Insert(v.cbegin() + 1, batch.begin(), batch.end());
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        check_unchanged();
+        assert(Obj::GetAliveObjectCount() == 6 + 4);
+
+        const Obj value(9);
+        Obj::copy_construction_throw_countdown = 3;
+        try {
+            v.Insert(v.cbegin() + 1, 3, value);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        check_unchanged();
+        assert(Obj::GetAliveObjectCount() == 6 + 4 + 1);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // Moves may throw, so the insertion relocates instead of shifting in place
+        std::vector<ThrowingCopy> batch(3);
+        batch[1].throw_on_copy = true;
+        Vector<ThrowingCopy> v(4);
+        v.Reserve(SIZE);
+        try {
+            v.Insert(v.cbegin() + 1, batch.begin(), batch.end());
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 4 && v.Capacity() == SIZE);
+        assert(ThrowingCopy::num_alive == 4 + 3);
+        batch[1].throw_on_copy = false;
+        v.Insert(v.cbegin() + 1, batch.begin(), batch.end());
+        assert(v.Size() == 7 && v.Capacity() == SIZE);
+    }
+    assert(ThrowingCopy::num_alive == 0);
+}
+
+void Test14() {
+    const size_t SIZE = 100;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i].id = static_cast<int>(i);
+        }
+        auto pos = v.Erase(v.cbegin() + 10, v.cbegin() + 20);
+        assert(pos == v.begin() + 10 && pos->id == 20);
+        assert(v.Size() == SIZE - 10 && v.Capacity() == SIZE);
+        assert(Obj::num_move_assigned == static_cast<int>(SIZE - 20));
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE - 10));
+        assert(v.Erase(v.cbegin(), v.cbegin()) == v.begin());
+
+        int calls = 0;
+        const size_t removed = EraseIf(v, [&calls](const Obj& obj) {
+            ++calls;
+            return obj.id % 3 == 0;
+            });
+        assert(calls == static_cast<int>(SIZE - 10));
+        assert(removed == 31);
+        assert(v.Size() == SIZE - 41);
+        assert(std::none_of(v.begin(), v.end(), [](const Obj& obj) {
+            return obj.id % 3 == 0;
+            }));
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE - 41));
+        v.Clear();
+        assert(v.Size() == 0 && v.Capacity() == SIZE);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Vector<int> v;
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            v.PushBack(i);
         }
-        Dump();
+        int calls = 0;
+        assert(EraseIf(v, [&calls](int value) {
+            ++calls;
+            return value % 10 < 3 || value == 55;
+            }) == 31);
+        assert(calls == static_cast<int>(SIZE));
+        assert(v.Size() == SIZE - 31 && v[0] == 3 && v[7] == 13);
+        assert(std::find(v.begin(), v.end(), 55) == v.end());
+        assert(EraseIf(v, [](int) {
+            return false;
+            }) == 0);
+        v.Erase(v.cbegin() + 1, v.cend() - 1);
+        assert(v.Size() == 2 && v[0] == 3 && v[1] == 99);
+    }
+    {
+        Vector<std::unique_ptr<int>> v;
+        for (int i = 0; i < 10; ++i) {
+            v.EmplaceBack(std::make_unique<int>(i));
+        }
+        v.Erase(v.cbegin(), v.cbegin() + 5);
+        assert(v.Size() == 5 && *v[0] == 5);
+    }
+}
+
+void Test15() {
+    const size_t SIZE = 100;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Resize(10);
+        v.ShrinkToFit();
+        assert(v.Size() == 10 && v.Capacity() == 10);
+        assert(Obj::num_moved == 10);
+        v.ShrinkToFit();
+        assert(Obj::num_moved == 10);
+        v.Clear();
+        v.ShrinkToFit();
+        assert(v.Capacity() == 0);
     }
-    catch (...) {
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Vector<int, std::allocator<int>, HysteresisGrowth<>> v;
+        for (int i = 0; i < 64; ++i) {
+            v.PushBack(i);
+        }
+        assert(v.Capacity() == 64);
+        while (v.Size() > 16) {
+            v.PopBack();
+        }
+        assert(v.Capacity() == 64);
+        v.PopBack();
+        assert(v.Capacity() == 32 && v.Size() == 15 && v[14] == 14);
+        v.Erase(v.cbegin(), v.cbegin() + 8);
+        assert(v.Capacity() == 16 && v.Size() == 7 && v[0] == 8);
+        v.Resize(1);
+        assert(v.Capacity() == 8);
+        v.Erase(v.cbegin());
+        assert(v.Capacity() == 4 && v.Size() == 0);
+
+        Vector<int, std::allocator<int>, HysteresisGrowth<>> raw;
+        raw.ResizeDefaultInit(64);
+        raw.ResizeDefaultInit(15);
+        assert(raw.Capacity() == 32 && raw.Size() == 15);
+    }
+}
+
+namespace {
+
+    struct StatsTestTag {
+    };
+
+    using CountedStats = VectorStats<StatsTestTag>;
+
+    size_t num_large_reallocations = 0;
+
+    void CountLargeReallocation(const ReallocationEvent& event) {
+        assert(event.new_bytes >= 1024);
+        ++num_large_reallocations;
+    }
+
+}  // namespace
+
+void Test16() {
+    static_assert(sizeof(Vector<int, std::allocator<int>, DefaultGrowth, NoVectorStats>) == sizeof(Vector<int>));
+    {
+        CountedStats::Reset();
+        Vector<Obj, std::allocator<Obj>, DefaultGrowth, CountedStats> v;
+        for (int i = 0; i < 5; ++i) {
+            v.EmplaceBack(i);
+        }
+        auto stats = CountedStats::Get();
+        assert(stats.allocations == 4);
+        assert(stats.bytes_allocated == (1 + 2 + 4 + 8) * sizeof(Obj));
+        assert(stats.reallocations == 3);
+        assert(stats.moved == 1 + 2 + 4);
+        assert(stats.copied == 0);
+        assert(stats.peak_capacity_bytes == 8 * sizeof(Obj));
+
+        v.Reserve(100);
+        v.Emplace(v.cbegin(), 0);
+        assert(CountedStats::Get().reallocations == 4);
+        assert(CountedStats::Get().moved == 1 + 2 + 4 + 5);
+    }
+    {
+        CountedStats::Reset();
+        num_large_reallocations = 0;
+        CountedStats::SetReallocationHook(1024, &CountLargeReallocation);
+        Vector<int, std::allocator<int>, DefaultGrowth, CountedStats> v;
+        for (int i = 0; i < 1024; ++i) {
+            v.PushBack(i);
+        }
+        CountedStats::SetReallocationHook(0, nullptr);
+        assert(CountedStats::Get().reallocations == 10);
+        assert(num_large_reallocations == 3);
+        assert(CountedStats::Get().peak_capacity_bytes == 1024 * sizeof(int));
+    }
+}
+
+void Test17() {
+    const size_t NUM_THREADS = 4;
+    const size_t PER_THREAD = 10'000;
+    {
+        ConcurrentVector<int> v;
+        int& first = v.PushBack(-1);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < NUM_THREADS; ++t) {
+            workers.emplace_back([&v, t] {
+                for (size_t i = 0; i < PER_THREAD; ++i) {
+                    v.EmplaceBack(static_cast<int>(t * PER_THREAD + i));
+                }
+                for (int& value : v.GrowBy(10)) {
+                    assert(value == 0);
+                    value = -2;
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        assert(&first == &v[0] && first == -1);
+        assert(v.Size() == NUM_THREADS * (PER_THREAD + 10) + 1);
+        assert(std::count(v.begin(), v.end(), -2) == static_cast<std::ptrdiff_t>(NUM_THREADS * 10));
+
+        Vector<int> compacted = v.Compact();
+        assert(v.Size() == 0);
+        assert(compacted.Size() == NUM_THREADS * (PER_THREAD + 10) + 1);
+        std::sort(compacted.begin(), compacted.end());
+        for (size_t i = 0; i < NUM_THREADS * PER_THREAD; ++i) {
+            assert(compacted[NUM_THREADS * 10 + 1 + i] == static_cast<int>(i));
+        }
+    }
+    {
+        Obj::ResetCounters();
+        ConcurrentVector<Obj> v;
+        v.EmplaceBack(1);
+        Obj::default_construction_throw_countdown = 20;
+        try {
+            v.GrowBy(100);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        v.EmplaceBack(2);
+        assert(Obj::GetAliveObjectCount() == 2 + 15);
+        Vector<Obj> compacted = v.Compact();
+        assert(compacted.Size() == 2 + 15);
+        assert(compacted[0].id == 1 && compacted[16].id == 2);
+        compacted.Clear();
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+}
+
+namespace {
+
+    // Thread-safe counterpart of Obj for the parallel overloads
+    struct SharedCounted {
+        SharedCounted() {
+            ++num_alive;
+        }
+
+        SharedCounted(const SharedCounted& other)
+            : throw_on_copy(other.throw_on_copy) {
+            if (other.throw_on_copy) {
+                throw std::runtime_error("Oops");
+            }
+            ++num_alive;
+            ++num_copied;
+        }
+
+        SharedCounted(SharedCounted&& other)
+            : throw_on_copy(other.throw_on_copy) {
+            ++num_alive;
+            ++num_copied;
+        }
+
+        ~SharedCounted() {
+            --num_alive;
+        }
+
+        bool throw_on_copy = false;
+
+        static inline std::atomic<int> num_alive = 0;
+        static inline std::atomic<int> num_copied = 0;
+    };
+
+}  // namespace
+
+void Test18() {
+    const size_t SIZE = 100'000;
+    const parallel_t policy(4);
+    {
+        Vector<std::string> v(policy, SIZE);
+        assert(v.Size() == SIZE && v[SIZE - 1].empty());
+        v[SIZE / 2] = "middle";
+        Vector<std::string> copy(policy, v);
+        assert(copy.Size() == SIZE && copy[SIZE / 2] == "middle");
+        copy.Reserve(policy, SIZE * 2);
+        assert(copy.Capacity() == SIZE * 2 && copy[SIZE / 2] == "middle");
+        copy.Resize(policy, SIZE * 3);
+        assert(copy.Size() == SIZE * 3 && copy[SIZE * 3 - 1].empty());
+        copy.Resize(policy, 10);
+        copy.Clear(policy);
+        assert(copy.Size() == 0);
+    }
+    {
+        Vector<SharedCounted> v(policy, SIZE);
+        v[SIZE - 10].throw_on_copy = true;
+        SharedCounted::num_copied = 0;
+        try {
+            Vector<SharedCounted> copy(policy, v);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(SharedCounted::num_alive == static_cast<int>(SIZE));
+
+        try {
+            v.Reserve(policy, SIZE * 2);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Capacity() == SIZE && v.Size() == SIZE);
+        assert(SharedCounted::num_alive == static_cast<int>(SIZE));
+
+        v[SIZE - 10].throw_on_copy = false;
+        v.Reserve(policy, SIZE * 2);
+        assert(v.Capacity() == SIZE * 2);
+        assert(SharedCounted::num_alive == static_cast<int>(SIZE));
+    }
+    assert(SharedCounted::num_alive == 0);
+}
+
+void Test19() {
+    struct Record {
+        uint64_t key;
+        double value;
+    };
+    const size_t SIZE = 10'000;
+    const std::string path = (std::filesystem::temp_directory_path() / "advanced_vector_mapped_test.bin").string();
+    std::filesystem::remove(path);
+    {
+        MappedVector<Record> v(path);
+        assert(v.Size() == 0);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(Record{ i, i * 0.5 });
+        }
+        assert(v.Size() == SIZE && v.Capacity() >= SIZE);
+        v.EmplaceBack(v[0]);
+        v.Sync();
+    }
+    {
+        MappedVector<Record> v(path);
+        assert(v.Size() == SIZE + 1);
+        assert(v[SIZE - 1].key == SIZE - 1 && v[SIZE - 1].value == (SIZE - 1) * 0.5);
+        assert(v[SIZE].key == 0);
+        v.PopBack();
+        v.Resize(SIZE * 2);
+        assert(v[SIZE * 2 - 1].key == 0);
+    }
+    {
+        MappedVector<Record> v(path, MapMode::PRIVATE);
+        assert(v.Size() == SIZE * 2);
+        v[0].key = 42;
+        v.Reserve(SIZE * 10);
+        assert(v[0].key == 42 && v[SIZE - 1].key == SIZE - 1);
+        v.Clear();
+    }
+    {
+        MappedVector<Record> v(path);
+        assert(v.Size() == SIZE * 2 && v[0].key == 0);
+    }
+    {
+        try {
+            MappedVector<int> v(path);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+void Test20() {
+    const size_t SIZE = 1000;
+    Vector<int> ints;
+    Vector<double> doubles;
+    for (size_t i = 0; i < SIZE; ++i) {
+        ints.PushBack(static_cast<int>(i));
+        doubles.PushBack(i * 0.25);
+    }
+    assert(AsBytes(ints).size == SIZE * sizeof(int));
+    assert(AsBytes(ints).data == reinterpret_cast<const std::byte*>(ints.Data()));
+    AsWritableBytes(ints).data[0] = std::byte{ 7 };
+    assert(ints[0] == 7);
+    ints[0] = 0;
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        throw std::runtime_error("pipe failed");
+    }
+    WriteAll(fds[1], ints, doubles);
+    WriteTo(fds[1], Vector<char>(3));
+    close(fds[1]);
+    {
+        Vector<int> ints_copy;
+        ints_copy.PushBack(-1);
+        assert(ReadFrom(fds[0], ints_copy, SIZE) == SIZE);
+        assert(ints_copy.Size() == SIZE + 1 && ints_copy[0] == -1);
+        assert(std::equal(ints.begin(), ints.end(), ints_copy.begin() + 1));
+
+        Vector<double> doubles_copy;
+        assert(ReadFrom(fds[0], doubles_copy, SIZE) == SIZE);
+        assert(std::equal(doubles.begin(), doubles.end(), doubles_copy.begin()));
+
+        // Only three bytes are left, so the read stops short at the end of input
+        Vector<char> tail;
+        assert(ReadFrom(fds[0], tail, 10) == 3);
+        assert(tail.Size() == 3 && tail.Capacity() >= 10 && tail[2] == 0);
+        assert(ReadFrom(fds[0], tail, 10) == 0);
+    }
+    close(fds[0]);
+
+    // Chunked reads grow the capacity by the policy instead of reallocating on every call
+    if (pipe(fds) != 0) {
+        throw std::runtime_error("pipe failed");
+    }
+    WriteTo(fds[1], ints);
+    close(fds[1]);
+    {
+        Vector<int> streamed;
+        size_t reallocations = 0;
+        for (size_t read = 1; read != 0;) {
+            const size_t capacity = streamed.Capacity();
+            read = ReadFrom(fds[0], streamed, 10);
+            reallocations += streamed.Capacity() != capacity ? 1 : 0;
+        }
+        assert(std::equal(ints.begin(), ints.end(), streamed.begin(), streamed.end()));
+        assert(reallocations < 20);
+    }
+    close(fds[0]);
+}
+
+void Test21() {
+    const size_t SIZE = 1 << 20;
+    // Returns the NUMA policy of the pages at address
+    auto policy_of = [](const void* address) {
+        int mode = -1;
+        unsigned long nodes[16] = {};
+        syscall(SYS_get_mempolicy, &mode, nodes, 1024, address, MPOL_F_ADDR);
+        return mode;
+    };
+    {
+        PageVector<int> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        assert(v.Size() == SIZE && v[SIZE - 1] == static_cast<int>(SIZE - 1));
+        v.Resize(10);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 10 && v[9] == 9);
+    }
+    {
+        PageVector<int> v(PageAllocator<int>(PagePolicy::BindTo(0)));
+        v.Reserve(SIZE);
+        assert(reinterpret_cast<uintptr_t>(v.Data()) % PagePolicy::HUGE_PAGE_SIZE == 0);
+        assert(policy_of(v.begin()) == MPOL_BIND);
+        v.Resize(SIZE);
+        v.Reserve(SIZE * 4);
+        assert(policy_of(v.begin() + SIZE * 3) == MPOL_BIND);
+        assert(v[SIZE - 1] == 0);
+
+        PageVector<int> interleaved(PageAllocator<int>(PagePolicy::Interleave()));
+        interleaved.Resize(SIZE);
+        assert(policy_of(interleaved.begin()) == MPOL_INTERLEAVE);
+
+        // The policy travels with the buffer
+        interleaved = v;
+        assert(interleaved.GetAllocator() == v.GetAllocator());
+        assert(policy_of(interleaved.begin()) == MPOL_BIND);
+        PageVector<int> first_touch;
+        first_touch.Resize(SIZE);
+        first_touch.Swap(v);
+        assert(first_touch.GetAllocator().GetPolicy().placement == NumaPlacement::BIND);
+        assert(v.GetAllocator().GetPolicy().placement == NumaPlacement::FIRST_TOUCH);
+    }
+    {
+        PagePolicy policy = PagePolicy::HugePages(4096);
+        policy.huge_pages = false;
+        PageVector<char> v{ PageAllocator<char>(policy) };
+        v.Resize(8192);
+        v.Resize(100);
+        v.ShrinkToFit();
+        assert(v.Size() == 100);
+    }
+}
+
+void Test22() {
+    // Usable in constant expressions, like the policies it wraps
+    static_assert(AlignedGrowth<64>::NextCapacity(0, 1, sizeof(float)) == 16);
+    static_assert(AlignedGrowth<64>::NextCapacity(16, 17, sizeof(float)) == 32);
+    static_assert(AlignedGrowth<32>::NextCapacity(5, 6, sizeof(double)) % 4 == 0);
+    auto is_aligned = [](const void* address, size_t alignment) {
+        return reinterpret_cast<uintptr_t>(address) % alignment == 0;
+    };
+    {
+        AlignedVector<float> v;
+        for (int i = 0; i < 100; ++i) {
+            v.PushBack(static_cast<float>(i));
+            assert(is_aligned(v.begin(), 64));
+            assert(v.Capacity() % 16 == 0);
+        }
+        assert(v[99] == 99.0f);
+        v.Reserve(1001);
+        assert(v.Capacity() == 1001 && is_aligned(v.begin(), 64));
+        v.ShrinkToFit();
+        assert(v.Capacity() == 100 && v[99] == 99.0f);
+    }
+    {
+        AlignedVector<double, 32> v(5);
+        assert(is_aligned(v.begin(), 32));
+        v.PushBack(1.0);
+        assert(v.Capacity() % 4 == 0 && v.Capacity() > 5);
+    }
+    {
+        // Over-aligned element types are honored by the default allocator as well
+        struct alignas(128) Line {
+            int value;
+        };
+        Vector<Line> v;
+        for (int i = 0; i < 20; ++i) {
+            v.PushBack(Line{ i });
+            assert(is_aligned(v.begin(), 128));
+        }
+        v.Insert(v.begin(), Line{ -1 });
+        assert(is_aligned(v.begin(), 128) && v[0].value == -1 && v[20].value == 19);
+    }
+}
+
+template <typename T>
+void CheckVectorOps(size_t size) {
+    const T value = static_cast<T>(5);
+    AlignedVector<T> v(size);
+    // vector_ops works on pointers
+    T* const first = v.Data();
+    T* const last = first + size;
+    vector_ops::Fill(first, last, value);
+    assert(std::all_of(v.begin(), v.end(), [value](T x) {
+        return x == value;
+    }));
+    for (size_t i = 0; i < size; ++i) {
+        v[i] = static_cast<T>(i == size - 1 ? 120 : (i == size / 3 ? -7 : static_cast<int>(i % 100)));
+    }
+    const auto expected_sum = std::accumulate(first, last, vector_ops::detail::SumType<T>{});
+    assert(vector_ops::Sum(first, last) == expected_sum);
+    const auto [lo, hi] = std::minmax_element(v.begin(), v.end());
+    assert(vector_ops::MinMax(first, last) == std::make_pair(*lo, *hi));
+    assert(vector_ops::Find(first, last, static_cast<T>(-7)) == std::find(first, last, static_cast<T>(-7)));
+    assert(vector_ops::Find(first, last, static_cast<T>(101)) == last);
+    assert(vector_ops::Count(first, last, static_cast<T>(42)) == static_cast<size_t>(std::count(first, last, static_cast<T>(42))));
+
+    Vector<T> copy(v.begin(), v.end());
+    T* const copy_first = copy.Data();
+    T* const copy_last = copy_first + size;
+    assert(vector_ops::Compare(first, last, copy_first, copy_last) == 0);
+    assert(vector_ops::Compare(first, last - 1, copy_first, copy_last) < 0);
+    copy[size - 2] = static_cast<T>(copy[size - 2] + 1);
+    assert(vector_ops::Compare(first, last, copy_first, copy_last) < 0);
+    assert(vector_ops::Compare(copy_first, copy_last, first, last) > 0);
+
+    vector_ops::Transform(first, last, copy_first, [](auto x) {
+        return x + 1;
+    });
+    for (size_t i = 0; i < size; ++i) {
+        assert(copy[i] == static_cast<T>(v[i] + 1));
+    }
+    vector_ops::Transform(first, last, first, [](T x) {
+        return static_cast<T>(x / 2);
+    });
+    assert(v[size - 1] == static_cast<T>(60));
+}
+
+void Test23() {
+    const vector_ops::Isa detected = vector_ops::DetectIsa();
+    for (vector_ops::Isa isa : { vector_ops::Isa::SSE2, vector_ops::Isa::AVX2, vector_ops::Isa::AVX512 }) {
+        if (detected == vector_ops::Isa::NEON || detected == vector_ops::Isa::SCALAR || isa > detected) {
+            continue;
+        }
+        vector_ops::ForceIsa(isa);
+        for (size_t size : { 3, 17, 1000, 100'007 }) {
+            CheckVectorOps<int>(size);
+            CheckVectorOps<float>(size);
+            CheckVectorOps<double>(size);
+            CheckVectorOps<int8_t>(size);
+        }
+        Vector<uint8_t> bytes(70'000);
+        bytes[69'999] = 1;
+        assert(vector_ops::Sum(bytes.Data(), bytes.Data() + bytes.Size()) == 1);
+        vector_ops::Fill(bytes.Data(), bytes.Data() + bytes.Size(), uint8_t{ 255 });
+        assert(vector_ops::Sum(bytes.Data(), bytes.Data() + bytes.Size()) == 255u * 70'000);
+        assert(vector_ops::Count(bytes.Data(), bytes.Data() + bytes.Size(), uint8_t{ 255 }) == 70'000);
+        assert(vector_ops::MinMax(bytes.Data(), bytes.Data() + 1) == std::make_pair(uint8_t{ 255 }, uint8_t{ 255 }));
+    }
+    vector_ops::ForceIsa(detected);
+}
+
+void Test24() {
+    Obj::ResetCounters();
+    const size_t SIZE = 1000;
+    {
+        SoAVector<int, double, Obj> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i), i * 0.5, static_cast<int>(i));
+        }
+        assert(v.Size() == SIZE && v.Capacity() >= SIZE);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE));
+        assert(Obj::num_copied == 0);
+
+        auto [id, weight, obj] = v[10];
+        assert(id == 10 && weight == 5.0 && obj.id == 10);
+        id = -10;
+        assert(v.Get<0>(10) == -10);
+
+        double total = 0;
+        for (double w : v.Column<1>()) {
+            total += w;
+        }
+        assert(total == (SIZE - 1) * SIZE / 4.0);
+        assert(v.Column<2>().size == SIZE && v.Column<2>()[SIZE - 1].id == static_cast<int>(SIZE - 1));
+
+        v.Erase(0, 10);
+        assert(v.Size() == SIZE - 10 && v.Get<0>(0) == -10 && v.Get<2>(0).id == 10);
+        v.Erase(v.Size() - 1);
+        v.PopBack();
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE - 12));
+
+        // Arguments referring to elements survive the growth they cause
+        v.Resize(v.Capacity());
+        v.EmplaceBack(v.Get<0>(0), v.Get<1>(0), v.Get<2>(0));
+        assert(v.Get<0>(v.Size() - 1) == -10 && v.Get<2>(v.Size() - 1).id == 10);
+
+        const SoAVector<int, double, Obj> copy = v;
+        assert(copy.Size() == v.Size() && std::get<2>(copy[0]).id == 10);
+        v.Clear();
+        assert(v.Size() == 0 && copy.Size() != 0);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // A failing element leaves the vector untouched, both when filling spare capacity
+        // and when the failure happens while growing
+        SoAVector<int, Obj> v;
+        v.Reserve(3);
+        v.EmplaceBack(1, Obj(1));
+        v.EmplaceBack(2, Obj(2));
+        Obj thrower(3);
+        thrower.throw_on_copy = true;
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            const size_t capacity = v.Capacity();
+            try {
+                v.PushBack(3, thrower);
+                assert(false && "Exception is expected");
+            }
+            catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == capacity - 1 + attempt && v.Capacity() == capacity && v.Get<1>(1).id == 2);
+            v.EmplaceBack(4, Obj(4));
+        }
+        assert(v.Size() == 4 && v.Get<0>(3) == 4);
+    }
+    {
+        // Columns whose move may throw are copied during growth
+        struct Copyable {
+            explicit Copyable(int value)
+                : value(value) {
+            }
+            Copyable(const Copyable& other)
+                : value(other.value) {
+            }
+            int value;
+        };
+        SoAVector<std::string, Copyable> v;
+        for (int i = 0; i < 100; ++i) {
+            v.EmplaceBack(std::string(20, 'a'), i);
+        }
+        assert(v.Get<1>(99).value == 99 && v.Get<0>(0) == std::string(20, 'a'));
+    }
+    {
+        // A throwing move of a move-only column propagates instead of terminating
+        struct MoveOnly {
+            explicit MoveOnly(int value)
+                : value(value) {
+            }
+            MoveOnly(const MoveOnly&) = delete;
+            MoveOnly(MoveOnly&& other) noexcept(false)
+                : value(other.value) {
+                if (other.throw_on_move) {
+                    throw std::runtime_error("move");
+                }
+            }
+            int value;
+            bool throw_on_move = false;
+        };
+        SoAVector<std::string, MoveOnly> v;
+        v.EmplaceBack(std::string(20, 'a'), MoveOnly(0));
+        v.Get<1>(0).throw_on_move = true;
+        const size_t capacity = v.Capacity();
+        try {
+            v.Reserve(capacity + 1);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 1 && v.Capacity() == capacity && v.Get<0>(0) == std::string(20, 'a'));
+        v.Get<1>(0).throw_on_move = false;
+        v.Reserve(capacity + 1);
+        assert(v.Get<1>(0).value == 0 && v.Capacity() == capacity + 1);
+    }
+    {
+        // A throwing move assignment during Erase leaves every row in place
+        struct Assigner {
+            Assigner(int value, bool throw_on_assign)
+                : value(value)
+                , throw_on_assign(throw_on_assign) {
+            }
+            Assigner(Assigner&&) = default;
+            Assigner& operator=(Assigner&& other) noexcept(false) {
+                if (other.throw_on_assign) {
+                    throw std::runtime_error("assign");
+                }
+                value = other.value;
+                return *this;
+            }
+            int value;
+            bool throw_on_assign;
+        };
+        SoAVector<Obj, int, Assigner> v;
+        for (int i = 0; i < 3; ++i) {
+            v.EmplaceBack(Obj(i), i, Assigner(i, i == 2));
+        }
+        try {
+            v.Erase(0);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 3 && Obj::GetAliveObjectCount() == 3);
+        assert(v.Get<1>(0) == 0 && v.Get<1>(2) == 2 && v.Get<2>(2).value == 2);
+        v.Get<2>(2).throw_on_assign = false;
+        v.Erase(0);
+        assert(v.Size() == 2 && Obj::GetAliveObjectCount() == 2);
+        assert(v.Get<1>(0) == 1 && v.Get<1>(1) == 2 && v.Get<2>(1).value == 2);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test25() {
+    Obj::ResetCounters();
+    const size_t SIZE = 10'000;
+    struct Large {
+        char bytes[1 << 20];
+    };
+    static_assert(SegmentedVector<int>::CHUNK_SIZE == 16384 && SegmentedVector<Large>::CHUNK_SIZE == 16);
+    {
+        SegmentedVector<Obj, 6> v;
+        v.EmplaceBack(0);
+        Obj* first = &v[0];
+        for (size_t i = 1; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        // Growth adds chunks instead of moving elements
+        assert(&v[0] == first && Obj::num_moved == 0 && Obj::num_copied == 0);
+        assert(v.Size() == SIZE && v.Capacity() == (SIZE + 63) / 64 * 64);
+        assert(v[SIZE - 1].id == static_cast<int>(SIZE - 1));
+        assert(std::is_sorted(v.begin(), v.end(), [](const Obj& lhs, const Obj& rhs) {
+            return lhs.id < rhs.id;
+        }));
+        assert(v.end() - v.begin() == static_cast<std::ptrdiff_t>(SIZE));
+
+        v.EmplaceBack(v[0]);
+        assert(v[SIZE].id == 0);
+        v.PopBack();
+
+        const SegmentedVector<Obj, 6> copy = v;
+        const Vector<Obj> flat = copy.Flatten();
+        assert(flat.Size() == SIZE && flat[SIZE - 1].id == static_cast<int>(SIZE - 1));
+
+        // A copy that throws half-way destroys what it has copied
+        const int alive = Obj::GetAliveObjectCount();
+        v[SIZE / 2].throw_on_copy = true;
+        try {
+            const SegmentedVector<Obj, 6> failed = v;
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == alive);
+        v[SIZE / 2].throw_on_copy = false;
+
+        const Vector<Obj> moved = std::move(v).Flatten();
+        assert(moved.Size() == SIZE && v.Size() == 0 && v.Capacity() != 0);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 0);
+        v.Reserve(65);
+        assert(v.Capacity() == 128);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test26() {
+    BlockPool::Trim();
+    BlockPool::ResetStats();
+    {
+        // Short-lived vectors reuse the blocks of the previous iteration
+        for (int i = 0; i < 100; ++i) {
+            PooledVector<int> v;
+            for (int j = 0; j < 1000; ++j) {
+                v.PushBack(j);
+            }
+            assert(v[999] == 999);
+        }
+        const PoolStats stats = BlockPool::GetStats();
+        assert(stats.hits + stats.misses == 100 * 11);
+        assert(stats.misses <= 11 && stats.HitRate() > 0.98);
+    }
+    {
+        // Blocks freed on another thread go back to the thread that allocated them
+        BlockPool::Trim();
+        BlockPool::ResetStats();
+        auto v = std::make_unique<PooledVector<std::string>>(100);
+        std::thread([&v] {
+            v.reset();
+        }).join();
+        assert(BlockPool::GetStats().remote_frees == 0);
+        PooledVector<std::string> reused(100);
+        const PoolStats stats = BlockPool::GetStats();
+        assert(stats.remote_frees == 1 && stats.hits == 1);
+    }
+    {
+        // Caches stay bounded and large blocks bypass the pool
+        BlockPool::Trim();
+        BlockPool::ResetStats();
+        std::vector<PooledVector<char>> buffers;
+        for (int i = 0; i < 8; ++i) {
+            buffers.emplace_back(BlockPool::MAX_BLOCK_BYTES);
+        }
+        buffers.clear();
+        assert(BlockPool::GetStats().released == 4);
+        PooledVector<char> huge(BlockPool::MAX_BLOCK_BYTES * 2);
+        assert(BlockPool::GetStats().misses == 8);
+    }
+    BlockPool::Trim();
+}
+
+void Test27() {
+    Obj::ResetCounters();
+    const size_t SIZE = 1000;
+    {
+        Vector<Obj> config;
+        for (size_t i = 0; i < SIZE; ++i) {
+            config.EmplaceBack(static_cast<int>(i));
+        }
+        const SharedVector<Obj> snapshot = Freeze(std::move(config));
+        assert(snapshot.Size() == SIZE && snapshot.UseCount() == 1);
+
+        // Copies share the elements, readers on other threads need no locks
+        std::vector<std::thread> readers;
+        std::atomic<long> total = 0;
+        for (int i = 0; i < 4; ++i) {
+            readers.emplace_back([copy = snapshot, &total] {
+                long sum = 0;
+                for (const Obj& obj : copy) {
+                    sum += obj.id;
+                }
+                total += sum;
+            });
+        }
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        assert(total == 4L * (SIZE - 1) * SIZE / 2);
+        assert(Obj::num_copied == 0 && snapshot.UseCount() == 1);
+
+        // Writers detach from shared snapshots only
+        SharedVector<Obj> writer = snapshot;
+        assert(snapshot.UseCount() == 2);
+        writer.Edit([](Vector<Obj>& data) {
+            data[0].id = -1;
+        });
+        assert(Obj::num_copied == static_cast<int>(SIZE));
+        assert(snapshot[0].id == 0 && writer[0].id == -1 && snapshot.UseCount() == 1 && writer.UseCount() == 1);
+        writer.Edit([](Vector<Obj>& data) {
+            data.PushBack(Obj(42));
+        });
+        assert(Obj::num_copied == static_cast<int>(SIZE) && writer.Size() == SIZE + 1);
+
+        const Vector<Obj> thawed = std::move(writer).Thaw();
+        assert(thawed.Size() == SIZE + 1 && writer.Size() == 0 && Obj::num_copied == static_cast<int>(SIZE));
+        SharedVector<Obj> empty;
+        empty.Edit([](Vector<Obj>& data) {
+            data.EmplaceBack(1);
+        });
+        assert(empty.Size() == 1 && empty[0].id == 1);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // Vectors with any growth or stats policy can be frozen
+        Vector<int, std::allocator<int>, CompactGrowth> compact(3);
+        const SharedVector<int, std::allocator<int>, CompactGrowth> frozen = Freeze(std::move(compact));
+        SharedVector<int, std::allocator<int>, CompactGrowth> edited = frozen;
+        edited.Edit([](Vector<int, std::allocator<int>, CompactGrowth>& data) {
+            data.PushBack(4);
+        });
+        assert(frozen.Size() == 3 && edited.Size() == 4 && edited[3] == 4);
+        const Vector<int, std::allocator<int>, CompactGrowth> thawed = std::move(edited).Thaw();
+        assert(thawed.Capacity() == 4);
+    }
+}
+
+void Test28() {
+    const size_t SIZE = 5;
+    auto make = [](size_t size, size_t inner_size) {
+        Vector<Vector<int>> v;
+        for (size_t i = 0; i < size; ++i) {
+            v.EmplaceBack(inner_size);
+        }
+        return v;
+    };
+    {
+        // Growing copy-assignment keeps the inner buffers of the old elements
+        Vector<Vector<int>> target = make(3, 100);
+        const int* inner = target[0].begin();
+        const Vector<Vector<int>> source = make(SIZE, 10);
+        target = source;
+        assert(target.Size() == SIZE && target[0].Size() == 10);
+        assert(target[0].begin() == inner && target[0].Capacity() == 100 && target[4].Capacity() == 10);
+
+        Vector<std::string> strings(2);
+        strings[0].assign(100, 'a');
+        const char* chars = strings[0].data();
+        Vector<std::string> more(4);
+        more[0].assign(50, 'b');
+        strings = more;
+        assert(strings.Size() == 4 && strings[0] == more[0] && strings[0].data() == chars);
+    }
+    {
+        // AssignFrom swaps inner buffers with the source instead of freeing them
+        Vector<Vector<int>> current = make(SIZE, 100);
+        Vector<Vector<int>> next = make(SIZE - 1, 10);
+        const Vector<int>* outer = current.begin();
+        const int* current_inner = current[0].begin();
+        const int* next_inner = next[0].begin();
+        current.AssignFrom(std::move(next));
+        assert(current.begin() == outer && current.Size() == SIZE - 1);
+        assert(current[0].begin() == next_inner && current[0].Size() == 10);
+        assert(next.Size() == SIZE - 1 && next[0].begin() == current_inner && next[0].Capacity() == 100);
+
+        Vector<Vector<int>> bigger = make(SIZE * 2, 1);
+        current.AssignFrom(std::move(bigger));
+        assert(current.Size() == SIZE * 2 && current[SIZE * 2 - 1].Size() == 1);
+        current.AssignFrom(std::move(current));
+        assert(current.Size() == SIZE * 2);
+    }
+}
+
+void Test29() {
+    const size_t SIZE = 100'003;
+    BitVector bits;
+    std::vector<bool> expected;
+    for (size_t i = 0; i < SIZE; ++i) {
+        const bool value = i % 3 == 0 || i % 7 == 0;
+        bits.PushBack(value);
+        expected.push_back(value);
+    }
+    assert(bits.Size() == SIZE && bits.Capacity() >= SIZE);
+    assert(bits.Count() == static_cast<size_t>(std::count(expected.begin(), expected.end(), true)));
+    for (size_t i = 0; i < SIZE; i += 97) {
+        assert(bits[i] == expected[i]);
+    }
+    bits[1] = true;
+    bits[0].Flip();
+    assert(bits[1] && !bits[0] && bits.FindFirst() == 1 && bits.FindFirst(2) == 3);
+
+    BitVector none(SIZE);
+    assert(none.Count() == 0 && none.FindFirst() == SIZE);
+    none[SIZE - 1] = true;
+    assert(none.FindFirst(SIZE / 2) == SIZE - 1);
+
+    BitVector mask(SIZE, true);
+    assert(mask.Count() == SIZE);
+    mask.And(bits);
+    assert(mask == bits);
+    mask.Xor(bits);
+    assert(mask.Count() == 0);
+    mask.Or(none);
+    assert(mask.Count() == 1);
+    try {
+        mask.And(BitVector(10));
+        assert(false && "Exception is expected");
+    }
+    catch (const std::invalid_argument&) {
+    }
+
+    // Shrinking clears the dropped bits, so growing again exposes only the new value
+    BitVector tail(130, true);
+    tail.Resize(65);
+    tail.Resize(200);
+    assert(tail.Count() == 65 && !tail[65]);
+    tail.Resize(300, true);
+    assert(tail.Count() == 165 && tail[299] && !tail[199]);
+    tail.PopBack();
+    assert(tail.Count() == 164);
+    BitVector copy = tail;
+    assert(copy == tail);
+    copy = BitVector(5, true);
+    assert(copy.Count() == 5 && copy != tail);
+}
+
+// Table generators for Test30; in C++20 they run at compile time
+VECTOR_CONSTEXPR std::array<int, 16> MakeSquares() {
+    Vector<int> squares;
+    squares.Reserve(4);
+    for (int i = 0; i < 16; ++i) {
+        squares.PushBack(i * i);
+    }
+    Vector<int> copy = squares;
+    copy.Resize(20);
+    copy.PopBack();
+    std::array<int, 16> table{};
+    size_t index = 0;
+    for (int value : copy) {
+        if (index < table.size()) {
+            table[index++] = value;
+        }
+    }
+    return table;
+}
+
+VECTOR_CONSTEXPR size_t TotalLength() {
+    Vector<std::string> words;
+    for (const char* word : {"alpha", "beta", "gamma", "delta", "epsilon"}) {
+        words.EmplaceBack(word);
+    }
+    words.ShrinkToFit();
+    Vector<std::string> moved = std::move(words);
+    size_t total = 0;
+    for (const std::string& word : moved) {
+        total += word.size();
+    }
+    return total + words.Size();
+}
+
+void Test30() {
+#if VECTOR_HAS_CONSTEXPR
+    static_assert(MakeSquares()[15] == 225);
+    static_assert(TotalLength() == 26);
+    constexpr std::array<int, 16> TABLE = MakeSquares();
+    static_assert(TABLE[0] == 0 && TABLE[7] == 49);
+#endif
+    // The same code keeps working at run time
+    const std::array<int, 16> table = MakeSquares();
+    for (int i = 0; i < 16; ++i) {
+        assert(table[static_cast<size_t>(i)] == i * i);
+    }
+    assert(TotalLength() == 26);
+}
+
+void Test31() {
+    static_assert(std::is_trivially_copyable_v<InplaceVector<int, 15>>);
+    static_assert(!std::is_trivially_copyable_v<InplaceVector<std::string, 4>>);
+    static_assert(std::is_same_v<InplaceVector<int, 255>::size_type, uint8_t>);
+    static_assert(std::is_same_v<InplaceVector<char, 1000>::size_type, uint16_t>);
+    // Fifteen ints and a one-byte size fit in a cache line
+    static_assert(sizeof(InplaceVector<int, 15>) == 64);
+    {
+        InplaceVector<int, 4> v;
+        size_t pushed = 0;
+        for (int i = 0; i < 5; ++i) {
+            pushed += v.TryPushBack(i) ? 1 : 0;
+        }
+        assert(pushed == 4 && v.IsFull() && v[3] == 3);
+        try {
+            v.PushBack(4);
+            assert(false);
+        }
+        catch (const std::bad_alloc&) {
+        }
+        try {
+            v.Insert(v.begin(), 4);
+            assert(false);
+        }
+        catch (const std::bad_alloc&) {
+        }
+        assert(v.Size() == 4 && v[0] == 0 && v[3] == 3);
+        v.Erase(v.begin() + 1, v.begin() + 3);
+        assert(v.Size() == 2 && v[0] == 0 && v[1] == 3);
+        v.Insert(v.begin() + 1, 7);
+        const InplaceVector<int, 4> copy = v;
+        assert(copy.Size() == 3 && copy[1] == 7 && copy[2] == 3);
+    }
+    {
+        InplaceVector<std::string, 3> v;
+        v.EmplaceBack(50, 'a');
+        v.EmplaceBack("b");
+        // Inserting a copy of an element that the shift moves
+        v.Insert(v.begin(), v[1]);
+        assert(v.Size() == 3 && v[0] == "b" && v[1] == std::string(50, 'a') && v[2] == "b");
+        const std::string* full = v.TryEmplaceBack("c");
+        assert(full == nullptr && v.Size() == 3);
+        v.Erase(v.begin());
+        InplaceVector<std::string, 3> other(1);
+        other = v;
+        assert(other.Size() == 2 && other[0] == std::string(50, 'a'));
+        InplaceVector<std::string, 3> moved = std::move(other);
+        assert(moved.Size() == 2 && other.Size() == 0);
+        other.Swap(moved);
+        assert(other.Size() == 2 && moved.Size() == 0 && other[1] == "b");
+        other.Resize(3);
+        assert(other[2].empty());
+        other.PopBack();
+        other.Clear();
+        assert(other.Size() == 0);
+    }
+}
+
+// Runs op in a child process and reports whether it was stopped by a failed check
+template <typename Operation>
+bool Traps(Operation op) {
+    std::cout.flush();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        op();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+void Test32() {
+    Vector<int> v(3);
+    assert(v.Data() == &v[0] && v.Data() + v.Size() == &*v.begin() + 3);
+#if VECTOR_HARDENED || VECTOR_DEBUG_ITERATORS
+    [[maybe_unused]] static volatile int sink = 0;
+    assert(Traps([&v] {
+        sink = v[v.Size()];
+    }));
+    assert(Traps([] {
+        Vector<int> empty;
+        empty.PopBack();
+    }));
+    assert(!Traps([&v] {
+        sink = v[v.Size() - 1];
+    }));
+#endif
+#if VECTOR_DEBUG_ITERATORS
+    // Iterators taken before a reallocation trap when used after it
+    assert(Traps([&v] {
+        auto it = v.begin();
+        v.Reserve(v.Capacity() + 1);
+        sink = *it;
+    }));
+    assert(Traps([&v] {
+        auto pos = v.cbegin() + 1;
+        v.ShrinkToFit();
+        v.PushBack(1);
+        v.Insert(pos, 5);
+    }));
+    // Growth within capacity keeps them valid
+    v.Reserve(10);
+    auto it = v.begin() + 1;
+    v.PushBack(4);
+    *it = 7;
+    assert(v[1] == 7 && it - v.begin() == 1);
+#endif
+}
+
+void Test33() {
+    {
+        FlatSet<int> set;
+        for (int key : { 5, 1, 9, 5, 3 }) {
+            set.Insert(key);
+        }
+        assert(set.Size() == 4 && std::is_sorted(set.begin(), set.end()));
+        assert(set.Contains(9) && !set.Contains(4) && set.Find(4) == set.end() && *set.Find(3) == 3);
+        assert(*set.LowerBound(4) == 5 && set.LowerBound(10) == set.end());
+        const auto [pos, inserted] = set.Insert(1);
+        assert(!inserted && *pos == 1);
+        const int more[] = { 8, 2, 9, 2, 0, 7 };
+        set.InsertRange(std::begin(more), std::end(more));
+        const int expected[] = { 0, 1, 2, 3, 5, 7, 8, 9 };
+        assert(std::equal(set.begin(), set.end(), std::begin(expected), std::end(expected)));
+        assert(set.Erase(5) == 1 && set.Erase(5) == 0 && set.Size() == 7);
+        set.Erase(set.begin());
+        assert(*set.begin() == 1);
+        // Lower bound agrees with std::lower_bound at every size, including empty
+        for (size_t size = 0; size < 40; ++size) {
+            FlatSet<int> evens;
+            evens.Reserve(size);
+            for (size_t i = 0; i < size; ++i) {
+                evens.Insert(static_cast<int>(2 * i));
+            }
+            for (int key = -1; key <= static_cast<int>(2 * size); ++key) {
+                assert(evens.LowerBound(key) == std::lower_bound(evens.begin(), evens.end(), key));
+            }
+        }
+        const std::string letters[] = { "b", "c", "a", "c" };
+        const FlatSet<std::string, std::greater<>> words(std::begin(letters), std::end(letters));
+        assert(words.Size() == 3 && *words.begin() == "c");
+    }
+    {
+        FlatMap<std::string, int> map;
+        map["pear"] = 1;
+        map["apple"] = 2;
+        assert(map.Insert("fig", 3).second && !map.Insert("pear", 10).second);
+        assert(map.Size() == 3 && map.At("pear") == 1 && map.KeyAt(0) == "apple" && map.ValueAt(1) == 3);
+        assert(map.Find("kiwi") == nullptr && map.Contains("fig"));
+        try {
+            map.At("kiwi");
+            assert(false);
+        }
+        catch (const std::out_of_range&) {
+        }
+        const std::pair<std::string, int> batch[] = { { "kiwi", 4 }, { "apple", 20 }, { "banana", 5 },
+                                                      { "kiwi", 40 }, { "cherry", 6 } };
+        map.InsertRange(std::begin(batch), std::end(batch));
+        const std::string keys[] = { "apple", "banana", "cherry", "fig", "kiwi", "pear" };
+        const int values[] = { 2, 5, 6, 3, 4, 1 };
+        assert(std::equal(map.Keys().begin(), map.Keys().end(), std::begin(keys), std::end(keys)));
+        assert(std::equal(map.Values().begin(), map.Values().end(), std::begin(values), std::end(values)));
+        assert(map.Erase("fig") == 1 && map.Erase("fig") == 0 && *map.Find("kiwi") == 4);
+        map.Reserve(100);
+        map.InsertRange(std::begin(batch), std::begin(batch));
+        assert(map.Size() == 5);
+    }
+    {
+        // A bulk insert that throws part-way leaves the container as it was
+        struct ThrowingLess {
+            int* budget;
+
+            bool operator()(int lhs, int rhs) const {
+                if (*budget > 0 && --*budget == 0) {
+                    throw std::runtime_error("compare");
+                }
+                return lhs < rhs;
+            }
+        };
+        int budget = 0;
+        FlatSet<int, ThrowingLess> set(ThrowingLess{ &budget });
+        FlatMap<int, std::string, ThrowingLess> map(ThrowingLess{ &budget });
+        for (int key = 0; key < 20; key += 2) {
+            set.Insert(key);
+            map.Insert(key, std::to_string(key));
+        }
+        const std::vector<int> old_keys(set.begin(), set.end());
+        const int more[] = { 7, 3, 30, 2, 11, 3, -1 };
+        std::pair<int, std::string> entries[std::size(more)];
+        std::transform(std::begin(more), std::end(more), std::begin(entries), [](int key) {
+            return std::pair(key, std::to_string(key));
+        });
+        int failures = 0;
+        for (int limit = 1;; ++limit) {
+            budget = limit;
+            try {
+                set.InsertRange(std::begin(more), std::end(more));
+                break;
+            }
+            catch (const std::runtime_error&) {
+                ++failures;
+                assert(std::equal(set.begin(), set.end(), old_keys.begin(), old_keys.end()));
+            }
+        }
+        for (int limit = 1;; ++limit) {
+            budget = limit;
+            try {
+                map.InsertRange(std::begin(entries), std::end(entries));
+                break;
+            }
+            catch (const std::runtime_error&) {
+                assert(std::equal(map.Keys().begin(), map.Keys().end(), old_keys.begin(), old_keys.end()));
+                assert(map.Values().Size() == old_keys.size() && map.ValueAt(9) == "18");
+            }
+        }
+        budget = 0;
+        assert(failures > 10 && set.Size() == 15 && map.Size() == 15 && map.At(-1) == "-1" && map.At(2) == "2");
+
+        // A value whose copy throws
+        FlatMap<int, Obj> objects;
+        objects.Insert(1, Obj(1));
+        std::pair<int, Obj> obj_batch[] = { { 0, Obj(0) }, { 2, Obj(2) }, { 3, Obj(3) } };
+        obj_batch[2].second.throw_on_copy = true;
+        try {
+            objects.InsertRange(std::begin(obj_batch), std::end(obj_batch));
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(objects.Size() == 1 && objects.Keys().Size() == 1 && objects.Values().Size() == 1);
+    }
+}
+
+using ProfiledVector = Vector<int, std::allocator<int>, DefaultGrowth, VectorProfiler>;
+
+// Sizes a vector that its caller grows and destroys
+__attribute__((noinline)) ProfiledVector MakeProfiledVector() {
+    ProfiledVector v;
+    v.Reserve(64);
+    return v;
+}
+
+// What the profiler recorded per site since `before` was taken; sites without changes are left out
+std::map<std::string, VectorProfiler::Site> ProfileSince(const std::vector<VectorProfiler::Site>& before) {
+    std::map<std::string, VectorProfiler::Site> delta;
+    for (const VectorProfiler::Site& site : VectorProfiler::Sites()) {
+        delta[site.name] = site;
+    }
+    for (const VectorProfiler::Site& site : before) {
+        VectorProfiler::Site& changed = delta[site.name];
+        changed.vectors -= site.vectors;
+        changed.reallocations -= site.reallocations;
+        changed.capacity_bytes -= site.capacity_bytes;
+        changed.size_bytes -= site.size_bytes;
+        if (changed.vectors == 0 && changed.reallocations == 0) {
+            delta.erase(site.name);
+        }
+    }
+    return delta;
+}
+
+// Capacity annotations and the profiling stats policy
+void Test34() {
+#if VECTOR_ANNOTATE_CONTAINER
+    {
+        Vector<int> v;
+        v.Reserve(16);
+        for (int i = 0; i < 4; ++i) {
+            v.PushBack(i);
+        }
+        const int* data = v.Data();
+        assert(!__asan_address_is_poisoned(data + 3) && __asan_address_is_poisoned(data + 4));
+        v.PopBack();
+        assert(__asan_address_is_poisoned(data + 3));
+        v.Resize(10);
+        assert(!__asan_address_is_poisoned(data + 9) && __asan_address_is_poisoned(data + 10));
+        v.Insert(v.begin(), 7);
+        assert(!__asan_address_is_poisoned(data + 10) && __asan_address_is_poisoned(data + 11));
+        v.Erase(v.begin(), v.begin() + 5);
+        assert(!__asan_address_is_poisoned(data + 5) && __asan_address_is_poisoned(data + 6));
+        v.Clear();
+        assert(__asan_address_is_poisoned(data));
+        // Growing moves the boundary into the new block
+        v.Resize(17);
+        assert(v.Data() != data && !__asan_address_is_poisoned(v.Data() + 16));
+        Vector<int> other(std::move(v));
+        other.Reserve(40);
+        assert(__asan_address_is_poisoned(other.Data() + 17));
+    }
+#endif
+    {
+        // Other tests share the profiler, so only what changes here is checked
+        const uint64_t live_before = VectorProfiler::LiveBytes();
+        const std::vector<VectorProfiler::Site> before = VectorProfiler::Sites();
+        {
+            ProfiledVector reserved;
+            reserved.Reserve(100);
+            for (int i = 0; i < 25; ++i) {
+                reserved.PushBack(i);
+            }
+            ProfiledVector grown;
+            for (int i = 0; i < 10; ++i) {
+                grown.PushBack(i);
+            }
+            assert(VectorProfiler::LiveBytes() == live_before + (reserved.Capacity() + grown.Capacity()) * sizeof(int));
+        }
+        assert(VectorProfiler::LiveBytes() == live_before);
+        assert(VectorProfiler::PeakBytes() >= live_before + 100 * sizeof(int));
+        uint64_t vectors = 0;
+        uint64_t reallocations = 0;
+        uint64_t capacity_bytes = 0;
+        uint64_t size_bytes = 0;
+        for (const auto& [name, site] : ProfileSince(before)) {
+            vectors += site.vectors;
+            reallocations += site.reallocations;
+            capacity_bytes += site.capacity_bytes;
+            size_bytes += site.size_bytes;
+        }
+        assert(vectors == 2 && reallocations > 0);
+        assert(size_bytes == 35 * sizeof(int) && capacity_bytes >= 110 * sizeof(int));
+        std::ostringstream report;
+        VectorProfiler::Report(report);
+        assert(report.str().find("% used") != std::string::npos);
+
+        // A vector is charged to where it was allocated, even when it grows and dies elsewhere
+        const std::vector<VectorProfiler::Site> before_returned = VectorProfiler::Sites();
+        {
+            ProfiledVector returned = MakeProfiledVector();
+            for (int i = 0; i < 100; ++i) {
+                returned.PushBack(i);
+            }
+        }
+        const std::map<std::string, VectorProfiler::Site> delta = ProfileSince(before_returned);
+        assert(delta.size() == 1);
+        const auto& [name, site] = *delta.begin();
+        assert(site.vectors == 1 && site.reallocations == 1);
+        assert(site.size_bytes == 100 * sizeof(int) && site.capacity_bytes == 128 * sizeof(int));
+        // Names are resolved only when the executable exports its symbols (-rdynamic)
+        const bool named = name.find("Test34") != std::string::npos || name.find("MakeProfiledVector") != std::string::npos;
+        assert(!named || name.find("MakeProfiledVector") != std::string::npos);
+    }
+}
+
+#if VECTOR_HAS_COROUTINES
+// Producer decoding comma-separated numbers into each buffer it is given
+AppendGenerator<int> DecodeNumbers(std::string text) {
+    AppendBuffer<int> buffer = co_yield 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t written = 0;
+        for (; written < buffer.size && pos < text.size(); ++written) {
+            const size_t end = std::min(text.find(',', pos), text.size());
+            buffer[written] = std::stoi(text.substr(pos, end - pos));
+            pos = end + 1;
+        }
+        buffer = co_yield written;
+    }
+}
+
+AppendGenerator<std::string> MakeWords(size_t count) {
+    AppendBuffer<std::string> buffer = co_yield 0;
+    size_t made = 0;
+    while (made < count) {
+        size_t written = 0;
+        for (; written < buffer.size && made < count; ++written, ++made) {
+            new(&buffer[written]) std::string(20, static_cast<char>('a' + made));
+        }
+        buffer = co_yield written;
+    }
+}
+#endif
+
+// Appends into prepared capacity, directly and from producer coroutines
+void Test35() {
+    {
+        Vector<int> v;
+        v.PushBack(1);
+        int* out = v.PrepareAppend(8);
+        assert(v.Capacity() >= 9 && out == v.Data() + 1 && v.Size() == 1);
+        for (int i = 0; i < 5; ++i) {
+            out[i] = 10 + i;
+        }
+        v.CommitAppend(5);
+        assert(v.Size() == 6 && v[1] == 10 && v[5] == 14);
+#if VECTOR_ANNOTATE_CONTAINER
+        assert(__asan_address_is_poisoned(v.Data() + 6));
+        out = v.PrepareAppend(2);
+        assert(!__asan_address_is_poisoned(out + 1));
+        v.CommitAppend(0);
+        assert(__asan_address_is_poisoned(out));
+#endif
+    }
+    {
+        // Small batches grow the capacity geometrically, as PushBack does
+        Vector<int> v;
+        size_t reallocations = 0;
+        for (int batch = 0; batch < 1000; ++batch) {
+            const size_t capacity = v.Capacity();
+            int* out = v.PrepareAppend(3);
+            reallocations += v.Capacity() != capacity ? 1 : 0;
+            out[0] = out[1] = batch;
+            v.CommitAppend(2);
+        }
+        assert(v.Size() == 2000 && v[1999] == 999 && reallocations < 20);
+    }
+    {
+        Vector<std::string> v;
+        VectorSink sink(v);
+        for (size_t round = 0; round < 3; ++round) {
+            AppendBuffer<std::string> buffer = sink.Prepare(4);
+            for (size_t i = 0; i < 3; ++i) {
+                new(&buffer[i]) std::string(20, static_cast<char>('a' + round));
+            }
+            sink.Commit(3);
+        }
+        assert(v.Size() == 9 && v[0] == std::string(20, 'a') && v[8] == std::string(20, 'c'));
+    }
+#if VECTOR_HAS_COROUTINES
+    {
+        Vector<int> v;
+        v.PushBack(-1);
+        const size_t added = DecodeNumbers("1,2,3,4,5,6,7,8,9,10").AppendTo(v, 3);
+        assert(added == 10 && v.Size() == 11 && v[1] == 1 && v[10] == 10);
+        // Chunks added before the producer fails are kept
+        try {
+            DecodeNumbers("11,12,x").AppendTo(v, 2);
+            assert(false);
+        }
+        catch (const std::invalid_argument&) {
+        }
+        assert(v.Size() == 13 && v[12] == 12);
+
+        Vector<std::string> words;
+        assert(MakeWords(7).AppendTo(words, 2) == 7);
+        assert(words.Size() == 7 && words[6] == std::string(20, 'g'));
     }
+#endif
 }
 
 int main() {
@@ -647,7 +2407,35 @@ int main() {
         Test4();
         Test5();
         Test6();
-        //Benchmark();
+        Test7();
+        Test8();
+        Test9();
+        Test10();
+        Test11();
+        Test12();
+        Test13();
+        Test14();
+        Test15();
+        Test16();
+        Test17();
+        Test18();
+        Test19();
+        Test20();
+        Test21();
+        Test22();
+        Test23();
+        Test24();
+        Test25();
+        Test26();
+        Test27();
+        Test28();
+        Test29();
+        Test30();
+        Test31();
+        Test32();
+        Test33();
+        Test34();
+        Test35();
     }
     catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
@@ -0,0 +1,347 @@
+#pragma once
+#include "vector.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum class MapMode {
+    // Changes go to the file and are visible to every process mapping it
+    SHARED,
+    // Copy-on-write view of the file; changes stay in this process
+    PRIVATE,
+};
+
+// Storage of a MappedVector: a file mapped into memory as a small header followed by the
+// element slots. Like RawMemory it hands out raw slots and knows nothing about their state
+template <typename T>
+class MappedMemory {
+    static_assert(std::is_trivially_copyable_v<T>, "mapped elements must be trivially copyable");
+    static_assert(alignof(T) <= 64, "elements are placed after a 64-byte header");
+
+    static constexpr uint64_t MAGIC = 0x31524f5443455621;  // "!VECTOR1"
+
+    struct Header {
+        uint64_t magic;
+        uint64_t elem_size;
+        uint64_t size;
+    };
+
+public:
+    static constexpr size_t HEADER_SIZE = 64;
+
+    MappedMemory() = default;
+
+    // Maps the file at path, creating an empty one if it is missing in SHARED mode
+    MappedMemory(const std::string& path, MapMode mode)
+        : mode_(mode) {
+        const int flags = mode == MapMode::SHARED ? O_RDWR | O_CREAT : O_RDONLY;
+        fd_ = open(path.c_str(), flags, 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+        try {
+            struct stat info {};
+            if (fstat(fd_, &info) != 0) {
+                throw std::system_error(errno, std::generic_category(), "fstat " + path);
+            }
+            size_t bytes = static_cast<size_t>(info.st_size);
+            if (bytes == 0) {
+                if (mode == MapMode::PRIVATE) {
+                    throw std::runtime_error("cannot privately map empty snapshot " + path);
+                }
+                bytes = RoundToPages(HEADER_SIZE);
+                Truncate(bytes);
+                Map(bytes);
+                *GetHeader() = Header{ MAGIC, sizeof(T), 0 };
+            }
+            else {
+                if (bytes < HEADER_SIZE) {
+                    throw std::runtime_error("truncated snapshot " + path);
+                }
+                Map(bytes);
+                const Header& header = *GetHeader();
+                if (header.magic != MAGIC || header.elem_size != sizeof(T)
+                    || header.size > (bytes - HEADER_SIZE) / sizeof(T)) {
+                    throw std::runtime_error("incompatible snapshot " + path);
+                }
+            }
+        }
+        catch (...) {
+            Release();
+            throw;
+        }
+    }
+
+    MappedMemory(const MappedMemory&) = delete;
+    MappedMemory& operator=(const MappedMemory&) = delete;
+
+    MappedMemory(MappedMemory&& other) noexcept {
+        Swap(other);
+    }
+
+    MappedMemory& operator=(MappedMemory&& rhs) noexcept {
+        if (this != &rhs) {
+            Release();
+            Swap(rhs);
+        }
+        return *this;
+    }
+
+    ~MappedMemory() {
+        Release();
+    }
+
+    T* operator+(size_t offset) noexcept {
+        assert(offset <= Capacity());
+        return GetAddress() + offset;
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < Capacity());
+        return GetAddress()[index];
+    }
+
+    T* GetAddress() noexcept {
+        return map_ != nullptr ? reinterpret_cast<T*>(static_cast<std::byte*>(map_) + HEADER_SIZE) : nullptr;
+    }
+
+    const T* GetAddress() const noexcept {
+        return const_cast<MappedMemory&>(*this).GetAddress();
+    }
+
+    size_t Capacity() const noexcept {
+        return map_ != nullptr ? (bytes_ - HEADER_SIZE) / sizeof(T) : 0;
+    }
+
+    // Element count persisted in the header
+    size_t StoredSize() const noexcept {
+        return map_ != nullptr ? static_cast<size_t>(GetHeader()->size) : 0;
+    }
+
+    void SetStoredSize(size_t size) noexcept {
+        if (map_ != nullptr) {
+            GetHeader()->size = size;
+        }
+    }
+
+    // Grows the mapping to at least new_capacity slots keeping their contents.
+    // SHARED mappings extend the file, PRIVATE ones move into anonymous memory
+    void Grow(size_t new_capacity) {
+        const size_t new_bytes = RoundToPages(HEADER_SIZE + new_capacity * sizeof(T));
+        if (new_bytes <= bytes_) {
+            return;
+        }
+        if (mode_ == MapMode::SHARED) {
+            Truncate(new_bytes);
+            Remap(new_bytes);
+        }
+        else {
+            void* anonymous = mmap(nullptr, new_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (anonymous == MAP_FAILED) {
+                throw std::system_error(errno, std::generic_category(), "mmap");
+            }
+            std::memcpy(anonymous, map_, bytes_);
+            munmap(map_, bytes_);
+            map_ = anonymous;
+            bytes_ = new_bytes;
+        }
+    }
+
+    // Flushes SHARED changes to the file
+    void Sync() {
+        if (mode_ == MapMode::SHARED && msync(map_, bytes_, MS_SYNC) != 0) {
+            throw std::system_error(errno, std::generic_category(), "msync");
+        }
+    }
+
+    void Swap(MappedMemory& other) noexcept {
+        std::swap(fd_, other.fd_);
+        std::swap(map_, other.map_);
+        std::swap(bytes_, other.bytes_);
+        std::swap(mode_, other.mode_);
+    }
+
+private:
+    static size_t RoundToPages(size_t bytes) noexcept {
+        static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return (bytes + page_size - 1) / page_size * page_size;
+    }
+
+    Header* GetHeader() const noexcept {
+        return static_cast<Header*>(map_);
+    }
+
+    void Truncate(size_t bytes) {
+        if (ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+            throw std::system_error(errno, std::generic_category(), "ftruncate");
+        }
+    }
+
+    void Map(size_t bytes) {
+        const int flags = mode_ == MapMode::SHARED ? MAP_SHARED : MAP_PRIVATE;
+        void* map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, fd_, 0);
+        if (map == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+        map_ = map;
+        bytes_ = bytes;
+    }
+
+    void Remap(size_t new_bytes) {
+#if defined(__linux__)
+        void* map = mremap(map_, bytes_, new_bytes, MREMAP_MAYMOVE);
+        if (map == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mremap");
+        }
+        map_ = map;
+        bytes_ = new_bytes;
+#else
+        // Shared pages already live in the file, so the old view can simply be replaced
+        const int flags = mode_ == MapMode::SHARED ? MAP_SHARED : MAP_PRIVATE;
+        void* map = mmap(nullptr, new_bytes, PROT_READ | PROT_WRITE, flags, fd_, 0);
+        if (map == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+        munmap(map_, bytes_);
+        map_ = map;
+        bytes_ = new_bytes;
+#endif
+    }
+
+    void Release() noexcept {
+        if (map_ != nullptr) {
+            munmap(map_, bytes_);
+            map_ = nullptr;
+            bytes_ = 0;
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int fd_ = -1;
+    void* map_ = nullptr;
+    size_t bytes_ = 0;
+    MapMode mode_ = MapMode::SHARED;
+};
+
+// Vector of trivially copyable records kept in a memory-mapped file. Opening an existing
+// snapshot maps it in O(1); growth extends the file and remaps it. The element count is
+// stored in the file, so a store is visible to the next Open once Sync has flushed it
+template <typename T, typename Growth = DefaultGrowth>
+class MappedVector {
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    MappedVector() = default;
+
+    explicit MappedVector(const std::string& path, MapMode mode = MapMode::SHARED)
+        : data_(path, mode)
+        , size_(data_.StoredSize()) {
+    }
+
+    iterator begin() noexcept {
+        return data_.GetAddress();
+    }
+
+    iterator end() noexcept {
+        return data_ + size_;
+    }
+
+    const_iterator begin() const noexcept {
+        return data_.GetAddress();
+    }
+
+    const_iterator end() const noexcept {
+        return data_.GetAddress() + size_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return data_.Capacity();
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity > data_.Capacity()) {
+            data_.Grow(new_capacity);
+        }
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size > size_) {
+            Reserve(new_size);
+            std::uninitialized_value_construct_n(data_ + size_, new_size - size_);
+        }
+        SetSize(new_size);
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ == Capacity()) {
+            // Arguments may refer to elements, so they are consumed before the file is remapped
+            T temp(std::forward<Args>(args)...);
+            data_.Grow(Growth::NextCapacity(Capacity(), size_ + 1, sizeof(T)));
+            new(data_ + size_) T(temp);
+        }
+        else {
+            new(data_ + size_) T(std::forward<Args>(args)...);
+        }
+        SetSize(size_ + 1);
+        return data_[size_ - 1];
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        SetSize(size_ - 1);
+    }
+
+    void Clear() noexcept {
+        SetSize(0);
+    }
+
+    // Flushes the elements and the element count to the file
+    void Sync() {
+        data_.Sync();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<MappedVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return data_[index];
+    }
+
+private:
+    void SetSize(size_t size) noexcept {
+        size_ = size;
+        data_.SetStoredSize(size);
+    }
+
+    MappedMemory<T> data_;
+    size_t size_ = 0;
+};
@@ -0,0 +1,259 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <system_error>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum class NumaPlacement {
+    // Pages land on the node of the thread that first touches them
+    FIRST_TOUCH,
+    // Pages are allocated on PagePolicy::node only
+    BIND,
+    // Pages are spread round-robin over every node the process may use
+    INTERLEAVE,
+};
+
+// Where and how PageAllocator places large blocks
+struct PagePolicy {
+    static constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20;
+
+    // Blocks of at least this many bytes are mapped directly; smaller ones come from malloc
+    size_t map_threshold = HUGE_PAGE_SIZE;
+    // Mapped blocks are aligned to HUGE_PAGE_SIZE and advised with MADV_HUGEPAGE
+    bool huge_pages = true;
+    NumaPlacement placement = NumaPlacement::FIRST_TOUCH;
+    int node = 0;
+
+    static PagePolicy HugePages(size_t threshold = HUGE_PAGE_SIZE) noexcept {
+        PagePolicy policy;
+        policy.map_threshold = threshold;
+        return policy;
+    }
+
+    static PagePolicy BindTo(int node) noexcept {
+        PagePolicy policy;
+        policy.placement = NumaPlacement::BIND;
+        policy.node = node;
+        return policy;
+    }
+
+    static PagePolicy Interleave() noexcept {
+        PagePolicy policy;
+        policy.placement = NumaPlacement::INTERLEAVE;
+        return policy;
+    }
+
+    bool operator==(const PagePolicy& other) const noexcept {
+        return map_threshold == other.map_threshold && huge_pages == other.huge_pages
+            && placement == other.placement && node == other.node;
+    }
+
+    bool operator!=(const PagePolicy& other) const noexcept {
+        return !(*this == other);
+    }
+};
+
+// Allocator for large scan-heavy buffers. Blocks above the policy threshold are mapped
+// with mmap, backed by transparent huge pages and bound to NUMA nodes with mbind; mapped
+// blocks grow with mremap through the Reallocate hook. The policy is part of the
+// allocator's state and travels with the buffer on copy, move and swap.
+// Outside Linux every block comes from malloc and the policy is ignored
+template <typename T>
+class PageAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    static_assert(alignof(T) <= alignof(std::max_align_t), "malloc cannot align T");
+
+    PageAllocator() = default;
+
+    explicit PageAllocator(const PagePolicy& policy) noexcept
+        : policy_(policy) {
+    }
+
+    template <typename U>
+    PageAllocator(const PageAllocator<U>& other) noexcept
+        : policy_(other.GetPolicy()) {
+    }
+
+    const PagePolicy& GetPolicy() const noexcept {
+        return policy_;
+    }
+
+    T* allocate(size_t n) {
+        const size_t bytes = Bytes(n);
+#if defined(__linux__)
+        if (IsMapped(bytes)) {
+            return static_cast<T*>(Map(MappedBytes(bytes)));
+        }
+#endif
+        void* buf = std::malloc(bytes);
+        if (buf == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(buf);
+    }
+
+    void deallocate(T* buf, size_t n) noexcept {
+#if defined(__linux__)
+        if (IsMapped(n * sizeof(T))) {
+            munmap(buf, MappedBytes(n * sizeof(T)));
+            return;
+        }
+#endif
+        std::free(buf);
+    }
+
+    T* Reallocate(T* buf, size_t old_n, size_t new_n) {
+        const size_t old_bytes = old_n * sizeof(T);
+        const size_t new_bytes = Bytes(new_n);
+#if defined(__linux__)
+        const bool old_mapped = IsMapped(old_bytes);
+        const bool new_mapped = IsMapped(new_bytes);
+        if (old_mapped && new_mapped) {
+            // A moved mapping may lose huge page alignment, which only costs the unaligned ends
+            const size_t new_length = MappedBytes(new_bytes);
+            void* new_buf = mremap(buf, MappedBytes(old_bytes), new_length, MREMAP_MAYMOVE);
+            if (new_buf == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            // The old mapping is gone now, so placement is best effort: if it fails, the pages
+            // keep the placement they had and the grown tail is placed on first touch
+            try {
+                Place(new_buf, new_length);
+            }
+            catch (...) {
+            }
+            return static_cast<T*>(new_buf);
+        }
+        if (old_mapped || new_mapped) {
+            T* new_buf = allocate(new_n);
+            std::memcpy(static_cast<void*>(new_buf), static_cast<const void*>(buf), std::min(old_bytes, new_bytes));
+            deallocate(buf, old_n);
+            return new_buf;
+        }
+#endif
+        void* new_buf = std::realloc(buf, new_bytes);
+        if (new_buf == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(new_buf);
+    }
+
+    template <typename U>
+    bool operator==(const PageAllocator<U>& other) const noexcept {
+        return policy_ == other.GetPolicy();
+    }
+
+    template <typename U>
+    bool operator!=(const PageAllocator<U>& other) const noexcept {
+        return !(*this == other);
+    }
+
+private:
+    static size_t Bytes(size_t n) {
+        if (n > static_cast<size_t>(-1) / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return n * sizeof(T);
+    }
+
+#if defined(__linux__)
+    static constexpr unsigned long MAX_NODES = 1024;
+
+    bool IsMapped(size_t bytes) const noexcept {
+        return bytes >= policy_.map_threshold;
+    }
+
+    // Length of the mapping behind a block, so deallocate can recover it from n alone
+    size_t MappedBytes(size_t bytes) const noexcept {
+        static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t granularity = policy_.huge_pages ? PagePolicy::HUGE_PAGE_SIZE : page_size;
+        return (bytes + granularity - 1) / granularity * granularity;
+    }
+
+    void* Map(size_t length) const {
+        // Huge pages only back aligned extents, so an aligned window is cut out of a larger mapping
+        const size_t slack = policy_.huge_pages ? PagePolicy::HUGE_PAGE_SIZE : 0;
+        void* map = mmap(nullptr, length + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        auto* first = static_cast<std::byte*>(map);
+        auto* aligned = first;
+        if (slack != 0) {
+            const size_t misalignment = reinterpret_cast<uintptr_t>(first) % slack;
+            aligned = first + (misalignment == 0 ? 0 : slack - misalignment);
+            if (aligned != first) {
+                munmap(first, static_cast<size_t>(aligned - first));
+            }
+            if (aligned + length != first + length + slack) {
+                munmap(aligned + length, static_cast<size_t>(first + length + slack - (aligned + length)));
+            }
+        }
+        try {
+            Place(aligned, length);
+        }
+        catch (...) {
+            munmap(aligned, length);
+            throw;
+        }
+        return aligned;
+    }
+
+    // Applies the policy to pages that have not been touched yet
+    void Place(void* buf, size_t length) const {
+        if (policy_.huge_pages) {
+            // Advisory only: kernels without transparent huge pages reject it harmlessly
+            madvise(buf, length, MADV_HUGEPAGE);
+        }
+        if (policy_.placement == NumaPlacement::FIRST_TOUCH) {
+            return;
+        }
+        unsigned long nodes[MAX_NODES / (8 * sizeof(unsigned long))] = {};
+        int mode = MPOL_BIND;
+        if (policy_.placement == NumaPlacement::BIND) {
+            if (policy_.node < 0 || static_cast<unsigned long>(policy_.node) >= MAX_NODES) {
+                throw std::system_error(EINVAL, std::generic_category(), "mbind");
+            }
+            const auto node = static_cast<unsigned long>(policy_.node);
+            nodes[node / (8 * sizeof(unsigned long))] = 1UL << node % (8 * sizeof(unsigned long));
+        }
+        else {
+            mode = MPOL_INTERLEAVE;
+            int current_mode = 0;
+            if (syscall(SYS_get_mempolicy, &current_mode, nodes, MAX_NODES, nullptr, MPOL_F_MEMS_ALLOWED) != 0) {
+                throw std::system_error(errno, std::generic_category(), "get_mempolicy");
+            }
+        }
+        if (syscall(SYS_mbind, buf, length, mode, nodes, MAX_NODES, 0) != 0) {
+            throw std::system_error(errno, std::generic_category(), "mbind");
+        }
+    }
+#endif
+
+    PagePolicy policy_;
+};
+
+// Vector for large buffers placed by a PagePolicy, e.g.
+//   PageVector<float> v(PageAllocator<float>(PagePolicy::BindTo(1)));
+template <typename T, typename Growth = HugePageGrowth>
+using PageVector = Vector<T, PageAllocator<T>, Growth>;
@@ -0,0 +1,316 @@
+#pragma once
+#include "vector.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+// Counters of the block pool summed over all threads
+struct PoolStats {
+    // Allocations served from a thread cache and ones that went to operator new
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Blocks freed by a thread other than the one that allocated them
+    uint64_t remote_frees = 0;
+    // Blocks handed back to operator delete because the cache was full
+    uint64_t released = 0;
+
+    double HitRate() const noexcept {
+        return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+    }
+};
+
+// Process-wide pool of power-of-two blocks from MIN_BLOCK_BYTES to MAX_BLOCK_BYTES.
+// Every thread caches freed blocks in its own free lists, one per size class, without
+// any synchronization. A block freed by another thread is pushed onto its owner's lock-free
+// return stack, which the owner drains when its lists run dry. A thread caches at most
+// MAX_CACHE_BYTES; larger requests and overflowing blocks go to operator new/delete.
+// The cache of an exited thread is kept and adopted by the next new thread
+class BlockPool {
+public:
+    static constexpr size_t MIN_BLOCK_BYTES = 64;
+    static constexpr size_t MAX_BLOCK_BYTES = size_t{1} << 20;
+    static constexpr size_t MAX_CACHE_BYTES = size_t{4} << 20;
+
+    static void* Allocate(size_t bytes) {
+        const size_t size_class = ClassOf(bytes);
+        if (size_class == NUM_CLASSES) {
+            return ::operator new(bytes);
+        }
+        ThreadCache* cache = ThreadCache::Current();
+        if (cache != nullptr) {
+            if (void* block = cache->Pop(size_class)) {
+                return block;
+            }
+            cache->Count(cache->misses);
+        }
+        auto* header = static_cast<Header*>(::operator new(sizeof(Header) + ClassBytes(size_class)));
+        header->owner = cache;
+        return header + 1;
+    }
+
+    static void Deallocate(void* block, size_t bytes) noexcept {
+        const size_t size_class = ClassOf(bytes);
+        if (size_class == NUM_CLASSES) {
+            ::operator delete(block);
+            return;
+        }
+        Header* header = static_cast<Header*>(block) - 1;
+        ThreadCache* owner = header->owner;
+        if (owner == nullptr) {
+            ::operator delete(header);
+        }
+        else if (owner == ThreadCache::Current()) {
+            owner->Push(header, size_class);
+        }
+        else {
+            owner->PushRemote(header, size_class);
+        }
+    }
+
+    static PoolStats GetStats() noexcept {
+        PoolStats stats;
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        for (ThreadCache* cache = registry.head; cache != nullptr; cache = cache->next_registered) {
+            stats.hits += cache->hits.load(std::memory_order_relaxed);
+            stats.misses += cache->misses.load(std::memory_order_relaxed);
+            stats.remote_frees += cache->remote_frees.load(std::memory_order_relaxed);
+            stats.released += cache->released.load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+    static void ResetStats() noexcept {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        for (ThreadCache* cache = registry.head; cache != nullptr; cache = cache->next_registered) {
+            cache->hits.store(0, std::memory_order_relaxed);
+            cache->misses.store(0, std::memory_order_relaxed);
+            cache->remote_frees.store(0, std::memory_order_relaxed);
+            cache->released.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns the blocks cached by the calling thread to operator delete
+    static void Trim() noexcept {
+        if (ThreadCache* cache = ThreadCache::Current()) {
+            cache->Trim();
+        }
+    }
+
+private:
+    static constexpr size_t MIN_CLASS_SHIFT = 6;
+    static constexpr size_t NUM_CLASSES = 15;
+
+    static_assert(MIN_BLOCK_BYTES == size_t{1} << MIN_CLASS_SHIFT);
+    static_assert(MAX_BLOCK_BYTES == size_t{1} << (MIN_CLASS_SHIFT + NUM_CLASSES - 1));
+
+    class ThreadCache;
+
+    // Precedes every pooled block and keeps it aligned for any type
+    struct alignas(std::max_align_t) Header {
+        ThreadCache* owner;
+    };
+
+    // A cached block reuses its header as a list node
+    struct FreeNode {
+        FreeNode* next;
+        size_t size_class;
+    };
+
+    static_assert(sizeof(FreeNode) <= sizeof(Header));
+
+    class ThreadCache {
+    public:
+        // The calling thread's cache, or nullptr once the thread is shutting down
+        static ThreadCache* Current() noexcept {
+            if (current_ == nullptr && !exited_) {
+                static thread_local Handle handle;
+            }
+            return current_;
+        }
+
+        void* Pop(size_t size_class) noexcept {
+            if (lists_[size_class] == nullptr) {
+                DrainRemote();
+            }
+            FreeNode* node = lists_[size_class];
+            if (node == nullptr) {
+                return nullptr;
+            }
+            lists_[size_class] = node->next;
+            cached_bytes_ -= ClassBytes(size_class);
+            Count(hits);
+            // The node overlays the header, so the owner is written back
+            return new(static_cast<void*>(node)) Header{ this } + 1;
+        }
+
+        void Push(Header* header, size_t size_class) noexcept {
+            if (cached_bytes_ + ClassBytes(size_class) > MAX_CACHE_BYTES) {
+                Count(released);
+                ::operator delete(header);
+                return;
+            }
+            lists_[size_class] = new(static_cast<void*>(header)) FreeNode{ lists_[size_class], size_class };
+            cached_bytes_ += ClassBytes(size_class);
+        }
+
+        // Called by other threads; a lock-free push onto the return stack
+        void PushRemote(Header* header, size_t size_class) noexcept {
+            auto* node = new(static_cast<void*>(header)) FreeNode{ remote_.load(std::memory_order_relaxed), size_class };
+            while (!remote_.compare_exchange_weak(node->next, node, std::memory_order_release,
+                                                  std::memory_order_relaxed)) {
+            }
+        }
+
+        void Trim() noexcept {
+            DrainRemote();
+            for (FreeNode*& list : lists_) {
+                while (list != nullptr) {
+                    FreeNode* next = list->next;
+                    ::operator delete(static_cast<void*>(list));
+                    list = next;
+                }
+            }
+            cached_bytes_ = 0;
+        }
+
+        // Counters have a single writer, so a relaxed load and store is enough
+        static void Count(std::atomic<uint64_t>& counter, uint64_t delta = 1) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+
+        std::atomic<uint64_t> hits = 0;
+        std::atomic<uint64_t> misses = 0;
+        std::atomic<uint64_t> remote_frees = 0;
+        std::atomic<uint64_t> released = 0;
+        ThreadCache* next_registered = nullptr;
+        bool in_use = false;
+
+    private:
+        // Binds a cache to the thread for its lifetime
+        struct Handle {
+            Handle() noexcept {
+                Registry& registry = GetRegistry();
+                std::lock_guard lock(registry.mutex);
+                ThreadCache* cache = registry.head;
+                while (cache != nullptr && cache->in_use) {
+                    cache = cache->next_registered;
+                }
+                if (cache == nullptr) {
+                    cache = new(std::nothrow) ThreadCache;
+                    if (cache == nullptr) {
+                        return;
+                    }
+                    cache->next_registered = registry.head;
+                    registry.head = cache;
+                }
+                cache->in_use = true;
+                current_ = cache;
+            }
+
+            ~Handle() {
+                exited_ = true;
+                ThreadCache* cache = std::exchange(current_, nullptr);
+                if (cache != nullptr) {
+                    cache->Trim();
+                    Registry& registry = GetRegistry();
+                    std::lock_guard lock(registry.mutex);
+                    cache->in_use = false;
+                }
+            }
+        };
+
+        // Moves blocks returned by other threads into the local lists
+        void DrainRemote() noexcept {
+            if (remote_.load(std::memory_order_relaxed) == nullptr) {
+                return;
+            }
+            FreeNode* node = remote_.exchange(nullptr, std::memory_order_acquire);
+            uint64_t drained = 0;
+            while (node != nullptr) {
+                FreeNode* next = node->next;
+                Push(static_cast<Header*>(static_cast<void*>(node)), node->size_class);
+                node = next;
+                ++drained;
+            }
+            Count(remote_frees, drained);
+        }
+
+        static inline thread_local ThreadCache* current_ = nullptr;
+        static inline thread_local bool exited_ = false;
+
+        FreeNode* lists_[NUM_CLASSES] = {};
+        size_t cached_bytes_ = 0;
+        std::atomic<FreeNode*> remote_ = nullptr;
+    };
+
+    // Caches are never freed: blocks may still name them as owner after their thread exits
+    struct Registry {
+        std::mutex mutex;
+        ThreadCache* head = nullptr;
+    };
+
+    static Registry& GetRegistry() noexcept {
+        static Registry* registry = new Registry;
+        return *registry;
+    }
+
+    static size_t ClassBytes(size_t size_class) noexcept {
+        return MIN_BLOCK_BYTES << size_class;
+    }
+
+    // Smallest class holding bytes, or NUM_CLASSES if the block is too large to pool
+    static size_t ClassOf(size_t bytes) noexcept {
+        size_t size_class = 0;
+        while (size_class < NUM_CLASSES && ClassBytes(size_class) < bytes) {
+            ++size_class;
+        }
+        return size_class;
+    }
+};
+
+// Stateless allocator drawing from BlockPool. Short-lived vectors of similar capacities
+// reuse each other's buffers without touching the global allocator
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    static_assert(alignof(T) <= alignof(std::max_align_t), "pooled blocks are aligned to max_align_t");
+
+    PoolAllocator() = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& /*other*/) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        if (n > static_cast<size_t>(-1) / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(BlockPool::Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* buf, size_t n) noexcept {
+        BlockPool::Deallocate(buf, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& /*other*/) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& /*other*/) const noexcept {
+        return false;
+    }
+};
+
+template <typename T, typename Growth = DefaultGrowth>
+using PooledVector = Vector<T, PoolAllocator<T>, Growth>;
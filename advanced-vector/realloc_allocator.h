@@ -0,0 +1,115 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Allocator on top of malloc/realloc. It provides the Reallocate hook, so Vector grows
+// trivially relocatable elements in place instead of copying them into a new block.
+// On Linux blocks of at least MMAP_THRESHOLD bytes are mapped directly and grown with
+// mremap, which moves page table entries rather than data
+template <typename T>
+class ReallocAllocator {
+public:
+    using value_type = T;
+
+    static constexpr size_t MMAP_THRESHOLD = size_t{1} << 20;
+
+    static_assert(alignof(T) <= alignof(std::max_align_t), "malloc cannot align T");
+
+    ReallocAllocator() = default;
+
+    template <typename U>
+    ReallocAllocator(const ReallocAllocator<U>& /*other*/) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        const size_t bytes = Bytes(n);
+#if defined(__linux__)
+        if (IsMapped(bytes)) {
+            void* buf = mmap(nullptr, RoundToPages(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (buf == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(buf);
+        }
+#endif
+        void* buf = std::malloc(bytes);
+        if (buf == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(buf);
+    }
+
+    void deallocate(T* buf, size_t n) noexcept {
+#if defined(__linux__)
+        if (IsMapped(n * sizeof(T))) {
+            munmap(buf, RoundToPages(n * sizeof(T)));
+            return;
+        }
+#endif
+        std::free(buf);
+    }
+
+    T* Reallocate(T* buf, size_t old_n, size_t new_n) {
+        const size_t old_bytes = old_n * sizeof(T);
+        const size_t new_bytes = Bytes(new_n);
+#if defined(__linux__)
+        const bool old_mapped = IsMapped(old_bytes);
+        const bool new_mapped = IsMapped(new_bytes);
+        if (old_mapped && new_mapped) {
+            void* new_buf = mremap(buf, RoundToPages(old_bytes), RoundToPages(new_bytes), MREMAP_MAYMOVE);
+            if (new_buf == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(new_buf);
+        }
+        if (old_mapped || new_mapped) {
+            T* new_buf = allocate(new_n);
+            std::memcpy(static_cast<void*>(new_buf), static_cast<const void*>(buf), std::min(old_bytes, new_bytes));
+            deallocate(buf, old_n);
+            return new_buf;
+        }
+#endif
+        void* new_buf = std::realloc(buf, new_bytes);
+        if (new_buf == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(new_buf);
+    }
+
+    template <typename U>
+    bool operator==(const ReallocAllocator<U>& /*other*/) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const ReallocAllocator<U>& /*other*/) const noexcept {
+        return false;
+    }
+
+private:
+    static size_t Bytes(size_t n) {
+        if (n > static_cast<size_t>(-1) / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return n * sizeof(T);
+    }
+
+#if defined(__linux__)
+    static bool IsMapped(size_t bytes) noexcept {
+        return bytes >= MMAP_THRESHOLD;
+    }
+
+    static size_t RoundToPages(size_t bytes) noexcept {
+        static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return (bytes + page_size - 1) / page_size * page_size;
+    }
+#endif
+};
@@ -0,0 +1,312 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace detail {
+
+// Chunks of about 64 KiB, but never fewer than 16 elements
+template <typename T>
+constexpr size_t DefaultChunkShift() noexcept {
+    size_t shift = 4;
+    while ((sizeof(T) << (shift + 1)) <= (size_t{64} << 10)) {
+        ++shift;
+    }
+    return shift;
+}
+
+}  // namespace detail
+
+// Append-oriented vector made of fixed-size RawMemory chunks of 2^ChunkShift elements and
+// an index of chunk pointers. Growing adds a chunk instead of relocating the elements, so
+// PushBack never moves elements and costs amortized O(1) (only the small chunk index is
+// relocated as it grows), references stay valid until the element is removed, and the peak
+// memory overhead is one chunk. Element i lives in chunk i >> ChunkShift
+template <typename T, size_t ChunkShift = detail::DefaultChunkShift<T>()>
+class SegmentedVector {
+    static_assert(ChunkShift < sizeof(size_t) * 8, "chunks must be addressable");
+
+    template <bool IsConst>
+    class Iterator {
+        using Owner = std::conditional_t<IsConst, const SegmentedVector, SegmentedVector>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Iterator() = default;
+
+        Iterator(Owner* owner, size_t index) noexcept
+            : owner_(owner)
+            , index_(index) {
+        }
+
+        // A mutable iterator converts to a const one
+        operator Iterator<true>() const noexcept {
+            return Iterator<true>(owner_, index_);
+        }
+
+        reference operator*() const noexcept {
+            return (*owner_)[index_];
+        }
+
+        pointer operator->() const noexcept {
+            return &(*owner_)[index_];
+        }
+
+        reference operator[](difference_type offset) const noexcept {
+            return (*owner_)[index_ + offset];
+        }
+
+        Iterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept {
+            Iterator old = *this;
+            ++index_;
+            return old;
+        }
+
+        Iterator& operator--() noexcept {
+            --index_;
+            return *this;
+        }
+
+        Iterator operator--(int) noexcept {
+            Iterator old = *this;
+            --index_;
+            return old;
+        }
+
+        Iterator& operator+=(difference_type offset) noexcept {
+            index_ += offset;
+            return *this;
+        }
+
+        Iterator& operator-=(difference_type offset) noexcept {
+            index_ -= offset;
+            return *this;
+        }
+
+        friend Iterator operator+(Iterator it, difference_type offset) noexcept {
+            return it += offset;
+        }
+
+        friend Iterator operator-(Iterator it, difference_type offset) noexcept {
+            return it -= offset;
+        }
+
+        friend difference_type operator-(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ == rhs.index_;
+        }
+
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ != rhs.index_;
+        }
+
+        friend bool operator<(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ < rhs.index_;
+        }
+
+    private:
+        Owner* owner_ = nullptr;
+        size_t index_ = 0;
+    };
+
+public:
+    using value_type = T;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    static constexpr size_t CHUNK_SIZE = size_t{1} << ChunkShift;
+
+    SegmentedVector() = default;
+
+    // If a copy throws, the elements copied so far are destroyed here and chunks_ frees the
+    // chunks, since the destructor does not run for a constructor that throws
+    SegmentedVector(const SegmentedVector& other) {
+        Reserve(other.size_);
+        try {
+            for (const T& elem : other) {
+                EmplaceBack(elem);
+            }
+        }
+        catch (...) {
+            Clear();
+            throw;
+        }
+    }
+
+    SegmentedVector(SegmentedVector&& other) noexcept {
+        Swap(other);
+    }
+
+    SegmentedVector& operator=(const SegmentedVector& rhs) {
+        if (this != &rhs) {
+            SegmentedVector copy(rhs);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    SegmentedVector& operator=(SegmentedVector&& rhs) noexcept {
+        if (this != &rhs) {
+            Clear();
+            Swap(rhs);
+        }
+        return *this;
+    }
+
+    ~SegmentedVector() {
+        Clear();
+    }
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    iterator end() noexcept {
+        return iterator(this, size_);
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, size_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return chunks_.Size() * CHUNK_SIZE;
+    }
+
+    void Swap(SegmentedVector& other) noexcept {
+        chunks_.Swap(other.chunks_);
+        std::swap(size_, other.size_);
+    }
+
+    // Allocates chunks up front so the next appends never call the allocator
+    void Reserve(size_t new_capacity) {
+        const size_t num_chunks = (new_capacity + CHUNK_SIZE - 1) >> ChunkShift;
+        chunks_.Reserve(num_chunks);
+        while (chunks_.Size() < num_chunks) {
+            chunks_.EmplaceBack(CHUNK_SIZE);
+        }
+    }
+
+    // Releases the chunks that hold no elements
+    void ShrinkToFit() {
+        const size_t num_chunks = (size_ + CHUNK_SIZE - 1) >> ChunkShift;
+        while (chunks_.Size() > num_chunks) {
+            chunks_.PopBack();
+        }
+        chunks_.ShrinkToFit();
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    // Elements never move, so arguments referring to them stay valid while a chunk is added
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ == Capacity()) {
+            chunks_.EmplaceBack(CHUNK_SIZE);
+        }
+        T* slot = Slot(size_);
+        new(slot) T(std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        --size_;
+        std::destroy_at(Slot(size_));
+    }
+
+    // Destroys the elements keeping the chunks
+    void Clear() noexcept {
+        ForEachRun([](T* first, size_t count) {
+            std::destroy_n(first, count);
+        });
+        size_ = 0;
+    }
+
+    // Copies the elements into a contiguous Vector
+    Vector<T> Flatten() const& {
+        Vector<T> result;
+        result.Reserve(size_);
+        ForEachRun([&result](const T* first, size_t count) {
+            result.Append(first, first + count);
+        });
+        return result;
+    }
+
+    // Moves the elements into a contiguous Vector, emptying this one
+    Vector<T> Flatten() && {
+        Vector<T> result;
+        result.Reserve(size_);
+        ForEachRun([&result](T* first, size_t count) {
+            result.Append(std::make_move_iterator(first), std::make_move_iterator(first + count));
+        });
+        Clear();
+        return result;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<SegmentedVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return *Slot(index);
+    }
+
+private:
+    T* Slot(size_t index) noexcept {
+        return chunks_[index >> ChunkShift] + (index & (CHUNK_SIZE - 1));
+    }
+
+    // Calls op(first, count) for the elements of every chunk in order
+    template <typename Operation>
+    void ForEachRun(Operation op) {
+        for (size_t first = 0; first < size_; first += CHUNK_SIZE) {
+            op(chunks_[first >> ChunkShift].GetAddress(), std::min(CHUNK_SIZE, size_ - first));
+        }
+    }
+
+    template <typename Operation>
+    void ForEachRun(Operation op) const {
+        const_cast<SegmentedVector&>(*this).ForEachRun([&op](T* first, size_t count) {
+            op(static_cast<const T*>(first), count);
+        });
+    }
+
+    Vector<RawMemory<T>> chunks_;
+    size_t size_ = 0;
+};
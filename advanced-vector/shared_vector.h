@@ -0,0 +1,129 @@
+#pragma once
+#include "vector.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Immutable, reference-counted snapshot of a Vector with any allocator and policies. Copies
+// share the elements and cost one atomic increment, and any number of threads may read a
+// snapshot without locking. Edit() detaches the calling instance first (copy-on-write) when
+// the elements are shared. Like std::shared_ptr, one SharedVector object must not be used by
+// several threads at once
+template <typename T, typename Allocator = std::allocator<T>, typename Growth = DefaultGrowth,
+          typename Stats = DefaultVectorStats>
+class SharedVector {
+public:
+    using value_type = T;
+    using const_iterator = const T*;
+    using Data = Vector<T, Allocator, Growth, Stats>;
+
+    SharedVector() = default;
+
+    explicit SharedVector(Data&& data)
+        : block_(new Block{ std::move(data) }) {
+    }
+
+    SharedVector(const SharedVector& other) noexcept
+        : block_(other.block_) {
+        if (block_ != nullptr) {
+            block_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    SharedVector(SharedVector&& other) noexcept
+        : block_(std::exchange(other.block_, nullptr)) {
+    }
+
+    SharedVector& operator=(const SharedVector& rhs) noexcept {
+        SharedVector copy(rhs);
+        Swap(copy);
+        return *this;
+    }
+
+    SharedVector& operator=(SharedVector&& rhs) noexcept {
+        SharedVector moved(std::move(rhs));
+        Swap(moved);
+        return *this;
+    }
+
+    ~SharedVector() {
+        Release();
+    }
+
+    const_iterator begin() const noexcept {
+        return block_ != nullptr ? block_->data.Data() : nullptr;
+    }
+
+    const_iterator end() const noexcept {
+        return block_ != nullptr ? block_->data.Data() + block_->data.Size() : nullptr;
+    }
+
+    size_t Size() const noexcept {
+        return block_ != nullptr ? block_->data.Size() : 0;
+    }
+
+    // Number of SharedVector objects sharing the elements
+    size_t UseCount() const noexcept {
+        return block_ != nullptr ? block_->refs.load(std::memory_order_relaxed) : 0;
+    }
+
+    void Swap(SharedVector& other) noexcept {
+        std::swap(block_, other.block_);
+    }
+
+    // Calls editor(Data&) on the elements, copying them into a fresh buffer first unless this
+    // is their only owner. Other snapshots keep seeing the old elements. The elements are
+    // writable only for the duration of the call: a copy of *this taken afterwards shares them,
+    // so editor must not keep references to them
+    template <typename Editor>
+    void Edit(Editor editor) {
+        if (block_ == nullptr) {
+            block_ = new Block{ Data() };
+        }
+        else if (block_->refs.load(std::memory_order_acquire) != 1) {
+            Block* copy = new Block{ block_->data };
+            Release();
+            block_ = copy;
+        }
+        editor(block_->data);
+    }
+
+    // Turns the snapshot back into a Vector, moving the elements out if they are not shared
+    Data Thaw() && {
+        if (block_ == nullptr) {
+            return Data();
+        }
+        Data result = block_->refs.load(std::memory_order_acquire) == 1 ? std::move(block_->data) : Data(block_->data);
+        Release();
+        return result;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        assert(index < Size());
+        return block_->data[index];
+    }
+
+private:
+    struct Block {
+        Data data;
+        std::atomic<size_t> refs = 1;
+    };
+
+    void Release() noexcept {
+        if (block_ != nullptr && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete block_;
+        }
+        block_ = nullptr;
+    }
+
+    Block* block_ = nullptr;
+};
+
+// Moves the elements of vector into a snapshot without copying them
+template <typename T, typename Allocator, typename Growth, typename Stats>
+SharedVector<T, Allocator, Growth, Stats> Freeze(Vector<T, Allocator, Growth, Stats>&& vector) {
+    return SharedVector<T, Allocator, Growth, Stats>(std::move(vector));
+}
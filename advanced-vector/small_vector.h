@@ -0,0 +1,258 @@
+#pragma once
+#include "vector.h"
+
+#include <cstddef>
+
+// Vector that keeps up to N elements inline and spills to a RawMemory block when it grows
+// past that. Element management and exception guarantees are the same as in Vector
+template <typename T, size_t N, typename Allocator = std::allocator<T>, typename Growth = DefaultGrowth>
+class SmallVector {
+    static_assert(N > 0, "inline capacity must not be zero");
+
+    using AllocTraits = std::allocator_traits<Allocator>;
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    iterator begin() noexcept {
+        return Data();
+    }
+
+    iterator end() noexcept {
+        return Data() + size_;
+    }
+
+    const_iterator begin() const noexcept {
+        return Data();
+    }
+
+    const_iterator end() const noexcept {
+        return Data() + size_;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return Data();
+    }
+
+    const_iterator cend() const noexcept {
+        return Data() + size_;
+    }
+
+    SmallVector() = default;
+
+    explicit SmallVector(const Allocator& alloc) noexcept
+        : heap_(alloc)
+    {
+    }
+
+    explicit SmallVector(size_t size, const Allocator& alloc = Allocator())
+        : heap_(alloc)
+    {
+        Reserve(size);
+        std::uninitialized_value_construct_n(Data(), size);
+        size_ = size;
+    }
+
+    SmallVector(const SmallVector& other)
+        : SmallVector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator()))
+    {
+    }
+
+    SmallVector(const SmallVector& other, const Allocator& alloc)
+        : heap_(alloc)
+    {
+        Reserve(other.size_);
+        std::uninitialized_copy_n(other.Data(), other.size_, Data());
+        size_ = other.size_;
+    }
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : heap_(other.GetAllocator())
+    {
+        MoveFrom(other);
+    }
+
+    SmallVector& operator=(const SmallVector& rhs) {
+        if (this != &rhs) {
+            if (rhs.size_ > Capacity()) {
+                SmallVector copy(rhs, GetAllocator());
+                *this = std::move(copy);
+            }
+            else {
+                detail::AssignWithinCapacity(Data(), size_, rhs.Data(), rhs.size_);
+                size_ = rhs.size_;
+            }
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>
+                                                       && AllocTraits::is_always_equal::value) {
+        if (this != &rhs) {
+            std::destroy_n(Data(), size_);
+            size_ = 0;
+            MoveFrom(rhs);
+        }
+        return *this;
+    }
+
+    ~SmallVector() {
+        std::destroy_n(Data(), size_);
+    }
+
+    Allocator GetAllocator() const noexcept {
+        return heap_.GetAllocator();
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity <= Capacity()) {
+            return;
+        }
+        RawMemory<T, Allocator> new_data(new_capacity, heap_.GetAllocator());
+        detail::CopyOrMove(Data(), size_, new_data.GetAddress());
+        heap_.Swap(new_data);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return IsInline() ? N : heap_.Capacity();
+    }
+
+    // Elements live in the inline buffer
+    bool IsInline() const noexcept {
+        return heap_.GetAddress() == nullptr;
+    }
+
+    void Swap(SmallVector& other) noexcept(std::is_nothrow_move_constructible_v<T>
+                                           && AllocTraits::is_always_equal::value) {
+        SmallVector temp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(temp);
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size < size_) {
+            std::destroy_n(Data() + new_size, size_ - new_size);
+        }
+        else if (new_size > size_) {
+            Reserve(new_size);
+            std::uninitialized_value_construct_n(Data() + size_, new_size - size_);
+        }
+        size_ = new_size;
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        std::destroy_at(Data() + (size_ - 1));
+        --size_;
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ == Capacity()) {
+            RawMemory<T, Allocator> new_data(NextCapacity(), heap_.GetAllocator());
+            new(new_data + size_) T(std::forward<Args>(args)...);
+            try {
+                detail::CopyOrMove(Data(), size_, new_data.GetAddress());
+            }
+            catch (...) {
+                std::destroy_at(new_data + size_);
+                throw;
+            }
+            heap_.Swap(new_data);
+        }
+        else {
+            new(Data() + size_) T(std::forward<Args>(args)...);
+        }
+        ++size_;
+        return Data()[size_ - 1];
+    }
+
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        if (pos == end()) {
+            return &EmplaceBack(std::forward<Args>(args)...);
+        }
+        size_t index = static_cast<size_t>(pos - begin());
+        if (size_ == Capacity()) {
+            RawMemory<T, Allocator> new_data(NextCapacity(), heap_.GetAllocator());
+            detail::EmplaceRelocating(Data(), size_, index, new_data.GetAddress(), std::forward<Args>(args)...);
+            heap_.Swap(new_data);
+        }
+        else {
+            detail::EmplaceShifting(Data(), size_, index, std::forward<Args>(args)...);
+        }
+        ++size_;
+        return begin() + index;
+    }
+
+    iterator Erase(const_iterator pos) noexcept(std::is_nothrow_move_assignable_v<T>) {
+        assert(size_ > 0);
+        size_t index = static_cast<size_t>(pos - begin());
+        detail::EraseShifting(Data(), size_, index);
+        --size_;
+        return begin() + index;
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<SmallVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return Data()[index];
+    }
+
+private:
+    T* Data() noexcept {
+        return IsInline() ? reinterpret_cast<T*>(inline_) : heap_.GetAddress();
+    }
+
+    const T* Data() const noexcept {
+        return const_cast<SmallVector&>(*this).Data();
+    }
+
+    size_t NextCapacity() const noexcept {
+        return Growth::NextCapacity(Capacity(), size_ + 1, sizeof(T));
+    }
+
+    // Takes the elements of an empty-handed *this from other, leaving other empty.
+    // A heap block is stolen when the allocators allow it, inline elements are relocated
+    void MoveFrom(SmallVector& other) {
+        assert(size_ == 0);
+        if (!other.IsInline() && heap_.IsAllocatorEqual(other.heap_)) {
+            heap_.Swap(other.heap_);
+        }
+        else {
+            Reserve(other.size_);
+            detail::CopyOrMove(other.Data(), other.size_, Data());
+        }
+        size_ = std::exchange(other.size_, 0);
+    }
+
+    RawMemory<T, Allocator> heap_;
+    size_t size_ = 0;
+    alignas(T) std::byte inline_[N * sizeof(T)];
+};
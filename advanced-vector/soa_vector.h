@@ -0,0 +1,363 @@
+#pragma once
+#include "vector.h"
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Contiguous view of one SoAVector column
+template <typename T>
+struct ColumnSpan {
+    T* data = nullptr;
+    size_t size = 0;
+
+    T* begin() const noexcept {
+        return data;
+    }
+
+    T* end() const noexcept {
+        return data + size;
+    }
+
+    T& operator[](size_t index) const noexcept {
+        assert(index < size);
+        return data[index];
+    }
+};
+
+// Structure-of-arrays vector: element i is the tuple of the i-th values of every column, and
+// each column is a separate RawMemory buffer, so a loop over one field reads only that field.
+// The columns share one size and one capacity and are grown together; growth and appends
+// give the strong exception guarantee whenever Vector would
+template <typename... Fields>
+class SoAVector {
+    static_assert(sizeof...(Fields) > 0, "SoAVector needs at least one field");
+
+    using Columns = std::tuple<RawMemory<Fields>...>;
+    using Indices = std::index_sequence_for<Fields...>;
+
+    template <size_t I>
+    using Field = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+public:
+    using reference = std::tuple<Fields&...>;
+    using const_reference = std::tuple<const Fields&...>;
+
+    SoAVector() = default;
+
+    explicit SoAVector(size_t size) {
+        Resize(size);
+    }
+
+    SoAVector(const SoAVector& other) {
+        Columns columns = MakeColumns(other.size_);
+        CopyColumns(other, columns, Indices{});
+        SwapColumns(columns_, columns);
+        size_ = other.size_;
+    }
+
+    SoAVector(SoAVector&& other) noexcept {
+        Swap(other);
+    }
+
+    SoAVector& operator=(const SoAVector& rhs) {
+        if (this != &rhs) {
+            SoAVector copy(rhs);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    SoAVector& operator=(SoAVector&& rhs) noexcept {
+        if (this != &rhs) {
+            Clear();
+            Swap(rhs);
+        }
+        return *this;
+    }
+
+    ~SoAVector() {
+        Clear();
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return std::get<0>(columns_).Capacity();
+    }
+
+    void Swap(SoAVector& other) noexcept {
+        SwapColumns(columns_, other.columns_);
+        std::swap(size_, other.size_);
+    }
+
+    // Grows every column to new_capacity. On failure the vector is left unchanged
+    void Reserve(size_t new_capacity) {
+        if (new_capacity > Capacity()) {
+            Columns columns = MakeColumns(new_capacity);
+            RelocateColumns(columns, Indices{});
+        }
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size < size_) {
+            DestroyRows(new_size, size_, Indices{});
+            size_ = new_size;
+        }
+        else if (new_size > size_) {
+            Reserve(new_size);
+            ValueConstructRows(size_, new_size, Indices{});
+            size_ = new_size;
+        }
+    }
+
+    // Appends a row built from one argument per field
+    template <typename... Args>
+    reference EmplaceBack(Args&&... args) {
+        static_assert(sizeof...(Args) == sizeof...(Fields), "EmplaceBack takes one argument per field");
+        if (size_ == Capacity()) {
+            // The row is built in the new columns first, as arguments may refer to elements
+            Columns columns = MakeColumns(Growth::NextCapacity(Capacity(), size_ + 1, RowSize()));
+            ConstructRow(columns, size_, Indices{}, std::forward<Args>(args)...);
+            try {
+                RelocateColumns(columns, Indices{});
+            }
+            catch (...) {
+                DestroyRow(columns, size_, sizeof...(Fields), Indices{});
+                throw;
+            }
+        }
+        else {
+            ConstructRow(columns_, size_, Indices{}, std::forward<Args>(args)...);
+        }
+        ++size_;
+        return (*this)[size_ - 1];
+    }
+
+    void PushBack(const Fields&... values) {
+        EmplaceBack(values...);
+    }
+
+    void PushBack(Fields&&... values) {
+        EmplaceBack(std::move(values)...);
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        --size_;
+        DestroyRow(columns_, size_, sizeof...(Fields), Indices{});
+    }
+
+    // Removes the rows [first, last) shifting the following ones left
+    void Erase(size_t first, size_t last) noexcept((std::is_nothrow_move_assignable_v<Fields> && ...)) {
+        assert(first <= last && last <= size_);
+        if (first != last) {
+            EraseRows(first, last, Indices{});
+            size_ -= last - first;
+        }
+    }
+
+    void Erase(size_t index) noexcept((std::is_nothrow_move_assignable_v<Fields> && ...)) {
+        Erase(index, index + 1);
+    }
+
+    void Clear() noexcept {
+        DestroyRows(0, size_, Indices{});
+        size_ = 0;
+    }
+
+    template <size_t I>
+    ColumnSpan<Field<I>> Column() noexcept {
+        return { std::get<I>(columns_).GetAddress(), size_ };
+    }
+
+    template <size_t I>
+    ColumnSpan<const Field<I>> Column() const noexcept {
+        return { std::get<I>(columns_).GetAddress(), size_ };
+    }
+
+    template <size_t I>
+    Field<I>& Get(size_t index) noexcept {
+        assert(index < size_);
+        return std::get<I>(columns_)[index];
+    }
+
+    template <size_t I>
+    const Field<I>& Get(size_t index) const noexcept {
+        return const_cast<SoAVector&>(*this).template Get<I>(index);
+    }
+
+    reference operator[](size_t index) noexcept {
+        assert(index < size_);
+        return std::apply([index](auto&... columns) {
+            return reference(columns[index]...);
+        }, columns_);
+    }
+
+    const_reference operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return std::apply([index](const auto&... columns) {
+            return const_reference(columns[index]...);
+        }, columns_);
+    }
+
+private:
+    using Growth = DefaultGrowth;
+
+    // Columns that can be relocated without throwing are moved; the others are copied
+    // first, so a failing copy can be rolled back while every source is still intact.
+    // Move-only columns whose move may throw are moved in that first pass, and if it fails
+    // the rows keep the moved-from values, as in Vector
+    template <typename T>
+    static constexpr bool RELOCATES_NOTHROW = is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>;
+
+    static constexpr size_t RowSize() noexcept {
+        return (sizeof(Fields) + ...);
+    }
+
+    static Columns MakeColumns(size_t capacity) {
+        return Columns(RawMemory<Fields>(capacity)...);
+    }
+
+    // Builds row `index` of columns from one argument per field; on failure the fields
+    // already built are destroyed
+    template <size_t... I, typename... Args>
+    static void ConstructRow(Columns& columns, size_t index, std::index_sequence<I...>, Args&&... args) {
+        size_t built = 0;
+        try {
+            ((new(std::get<I>(columns) + index) Fields(std::forward<Args>(args)), ++built), ...);
+        }
+        catch (...) {
+            DestroyRow(columns, index, built, Indices{});
+            throw;
+        }
+    }
+
+    // Destroys the first `count` fields of row `index`
+    template <size_t... I>
+    static void DestroyRow(Columns& columns, size_t index, size_t count, std::index_sequence<I...>) noexcept {
+        ((I < count ? std::destroy_at(std::get<I>(columns) + index) : void()), ...);
+    }
+
+    template <size_t... I>
+    void DestroyRows(size_t first, size_t last, std::index_sequence<I...>) noexcept {
+        (std::destroy(std::get<I>(columns_) + first, std::get<I>(columns_) + last), ...);
+    }
+
+    // Every column is shifted by move assignment before any is trimmed, so a throwing
+    // assignment leaves all size_ rows built. Trivially relocatable columns are moved
+    // bitwise only after that
+    template <size_t... I>
+    void EraseRows(size_t first, size_t last, std::index_sequence<I...>) {
+        (ShiftColumn<I>(first, last), ...);
+        (TrimColumn<I>(first, last), ...);
+    }
+
+    template <size_t I>
+    void ShiftColumn(size_t first, size_t last) {
+        if constexpr (!is_trivially_relocatable_v<Field<I>>) {
+            Field<I>* data = std::get<I>(columns_).GetAddress();
+            std::move(data + last, data + size_, data + first);
+        }
+    }
+
+    template <size_t I>
+    void TrimColumn(size_t first, size_t last) noexcept {
+        Field<I>* data = std::get<I>(columns_).GetAddress();
+        if constexpr (is_trivially_relocatable_v<Field<I>>) {
+            detail::EraseShifting(data, size_, first, last - first);
+        }
+        else {
+            std::destroy(data + (size_ - (last - first)), data + size_);
+        }
+    }
+
+    // Value-initializes rows [first, last) of every column; on failure nothing is left built
+    template <size_t... I>
+    void ValueConstructRows(size_t first, size_t last, std::index_sequence<I...>) {
+        size_t built = 0;
+        try {
+            ((std::uninitialized_value_construct(std::get<I>(columns_) + first, std::get<I>(columns_) + last), ++built),
+             ...);
+        }
+        catch (...) {
+            ((I < built ? std::destroy(std::get<I>(columns_) + first, std::get<I>(columns_) + last) : void()), ...);
+            throw;
+        }
+    }
+
+    template <size_t... I>
+    void CopyColumns(const SoAVector& other, Columns& columns, std::index_sequence<I...>) {
+        size_t copied = 0;
+        try {
+            ((std::uninitialized_copy_n(std::get<I>(other.columns_).GetAddress(), other.size_,
+                                        std::get<I>(columns).GetAddress()),
+              ++copied),
+             ...);
+        }
+        catch (...) {
+            ((I < copied ? void(std::destroy_n(std::get<I>(columns).GetAddress(), other.size_)) : void()), ...);
+            throw;
+        }
+    }
+
+    // Moves the rows into the new columns and adopts them
+    template <size_t... I>
+    void RelocateColumns(Columns& columns, std::index_sequence<I...>) {
+        size_t visited = 0;
+        try {
+            ((CopyColumnIfThrowing<I>(columns), ++visited), ...);
+        }
+        catch (...) {
+            ((I < visited ? DestroyCopiedColumn<I>(columns) : void()), ...);
+            throw;
+        }
+        (RelocateColumn<I>(columns), ...);
+        SwapColumns(columns_, columns);
+    }
+
+    template <size_t I>
+    void CopyColumnIfThrowing(Columns& columns) {
+        if constexpr (!RELOCATES_NOTHROW<Field<I>>) {
+            detail::UninitializedMoveIfNoexcept(std::get<I>(columns_).GetAddress(), size_,
+                                                std::get<I>(columns).GetAddress());
+        }
+    }
+
+    template <size_t I>
+    void DestroyCopiedColumn(Columns& columns) noexcept {
+        if constexpr (!RELOCATES_NOTHROW<Field<I>>) {
+            std::destroy_n(std::get<I>(columns).GetAddress(), size_);
+        }
+    }
+
+    // Relocates the nothrow columns and drops the sources of the copied ones
+    template <size_t I>
+    void RelocateColumn(Columns& columns) noexcept {
+        using T = Field<I>;
+        T* from = std::get<I>(columns_).GetAddress();
+        if constexpr (RELOCATES_NOTHROW<T>) {
+            detail::CopyOrMove(from, size_, std::get<I>(columns).GetAddress());
+        }
+        else {
+            std::destroy_n(from, size_);
+        }
+    }
+
+    static void SwapColumns(Columns& lhs, Columns& rhs) noexcept {
+        SwapColumns(lhs, rhs, Indices{});
+    }
+
+    template <size_t... I>
+    static void SwapColumns(Columns& lhs, Columns& rhs, std::index_sequence<I...>) noexcept {
+        (std::get<I>(lhs).Swap(std::get<I>(rhs)), ...);
+    }
+
+    Columns columns_;
+    size_t size_ = 0;
+};
@@ -0,0 +1,192 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// Element types shared by the tests and benchmarks. They count special member calls
+// and can be told to throw from construction or copying
+
+inline const uint32_t DEFAULT_COOKIE = 0xdeadbeef;
+
+struct TestObj {
+    TestObj() = default;
+    TestObj(const TestObj& other) = default;
+    TestObj& operator=(const TestObj& other) = default;
+    TestObj(TestObj&& other) = default;
+    TestObj& operator=(TestObj&& other) = default;
+    ~TestObj() {
+        cookie = 0;
+    }
+    [[nodiscard]] bool IsAlive() const noexcept {
+        return cookie == DEFAULT_COOKIE;
+    }
+    uint32_t cookie = DEFAULT_COOKIE;
+};
+
+struct Obj {
+    Obj() {
+        if (default_construction_throw_countdown > 0) {
+            if (--default_construction_throw_countdown == 0) {
+                throw std::runtime_error("Oops");
+            }
+        }
+        ++num_default_constructed;
+    }
+
+    explicit Obj(int id)
+        : id(id)  //
+    {
+        ++num_constructed_with_id;
+    }
+
+    Obj(int id, std::string name)
+        : id(id)
+        , name(std::move(name))  //
+    {
+        ++num_constructed_with_id_and_name;
+    }
+
+    Obj(const Obj& other)
+        : id(other.id)  //
+    {
+        if (other.throw_on_copy) {
+            throw std::runtime_error("Oops");
+        }
+        if (copy_construction_throw_countdown > 0) {
+            if (--copy_construction_throw_countdown == 0) {
+                throw std::runtime_error("Oops");
+            }
+        }
+        ++num_copied;
+    }
+
+    Obj(Obj&& other) noexcept
+        : id(other.id)  //
+    {
+        ++num_moved;
+    }
+
+    Obj& operator=(const Obj& other) {
+        if (this != &other) {
+            id = other.id;
+            name = other.name;
+            ++num_assigned;
+        }
+        return *this;
+    }
+
+    Obj& operator=(Obj&& other) noexcept {
+        id = other.id;
+        name = std::move(other.name);
+        ++num_move_assigned;
+        return *this;
+    }
+
+    ~Obj() {
+        ++num_destroyed;
+        id = 0;
+    }
+
+    static int GetAliveObjectCount() {
+        return num_default_constructed + num_copied + num_moved + num_constructed_with_id
+            + num_constructed_with_id_and_name - num_destroyed;
+    }
+
+    static void ResetCounters() {
+        default_construction_throw_countdown = 0;
+        copy_construction_throw_countdown = 0;
+        num_default_constructed = 0;
+        num_copied = 0;
+        num_moved = 0;
+        num_destroyed = 0;
+        num_constructed_with_id = 0;
+        num_constructed_with_id_and_name = 0;
+        num_assigned = 0;
+        num_move_assigned = 0;
+    }
+
+    bool throw_on_copy = false;
+    int id = 0;
+    std::string name;
+
+    static inline int default_construction_throw_countdown = 0;
+    static inline int copy_construction_throw_countdown = 0;
+    static inline int num_default_constructed = 0;
+    static inline int num_constructed_with_id = 0;
+    static inline int num_constructed_with_id_and_name = 0;
+    static inline int num_copied = 0;
+    static inline int num_moved = 0;
+    static inline int num_destroyed = 0;
+    static inline int num_assigned = 0;
+    static inline int num_move_assigned = 0;
+};
+
+// Copyable type whose move may throw, so relocation falls back to copying
+struct ThrowingCopy {
+    ThrowingCopy() {
+        ++num_alive;
+    }
+    ThrowingCopy(const ThrowingCopy& other)
+        : throw_on_copy(other.throw_on_copy)  //
+    {
+        if (other.throw_on_copy) {
+            throw std::runtime_error("Oops");
+        }
+        ++num_alive;
+    }
+    ThrowingCopy(ThrowingCopy&& other) noexcept(false)
+        : throw_on_copy(other.throw_on_copy)  //
+    {
+        ++num_alive;
+    }
+    ThrowingCopy& operator=(const ThrowingCopy& other) = default;
+    ~ThrowingCopy() {
+        --num_alive;
+    }
+
+    bool throw_on_copy = false;
+
+    static inline int num_alive = 0;
+};
+
+struct C {
+    C() noexcept {
+        ++def_ctor;
+    }
+    C(const C& /*other*/) noexcept {
+        ++copy_ctor;
+    }
+    C(C&& /*other*/) noexcept {
+        ++move_ctor;
+    }
+    C& operator=(const C& other) noexcept {
+        if (this != &other) {
+            ++copy_assign;
+        }
+        return *this;
+    }
+    C& operator=(C&& /*other*/) noexcept {
+        ++move_assign;
+        return *this;
+    }
+    ~C() {
+        ++dtor;
+    }
+
+    static void Reset() {
+        def_ctor = 0;
+        copy_ctor = 0;
+        move_ctor = 0;
+        copy_assign = 0;
+        move_assign = 0;
+        dtor = 0;
+    }
+
+    inline static size_t def_ctor = 0;
+    inline static size_t copy_ctor = 0;
+    inline static size_t move_ctor = 0;
+    inline static size_t copy_assign = 0;
+    inline static size_t move_assign = 0;
+    inline static size_t dtor = 0;
+};
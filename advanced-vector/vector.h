@@ -1,301 +1,1554 @@
 #pragma once
+#include "vector_stats.h"
+
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <memory_resource>
 #include <new>
+#include <thread>
+#include <type_traits>
 #include <utility>
 
+// In C++20 the vector can be used in constant expressions: buffers come from std::allocator
+// and elements are built with std::construct_at, which the compiler can evaluate
+#if defined(__cpp_constexpr_dynamic_alloc) && defined(__cpp_lib_constexpr_dynamic_alloc)
+#define VECTOR_CONSTEXPR constexpr
+#define VECTOR_HAS_CONSTEXPR 1
+#else
+#define VECTOR_CONSTEXPR
+#define VECTOR_HAS_CONSTEXPR 0
+#endif
+
+// Hardened mode keeps the bounds checks of operator[], PopBack and Erase in release builds:
+// a failed check is a branch predicted not taken into __builtin_trap. Debug iterators add
+// iterators that remember the generation of the buffer they point into and trap when used
+// after a reallocation. Iterators change type, so every translation unit of a program has
+// to be built with the same setting
+#ifndef VECTOR_HARDENED
+#define VECTOR_HARDENED 0
+#endif
+
+#ifndef VECTOR_DEBUG_ITERATORS
+#define VECTOR_DEBUG_ITERATORS 0
+#endif
+
+#if VECTOR_HARDENED || VECTOR_DEBUG_ITERATORS
+#define VECTOR_CHECK(condition) (__builtin_expect(!(condition), 0) ? __builtin_trap() : void())
+#else
+#define VECTOR_CHECK(condition) assert(condition)
+#endif
+
+// Under AddressSanitizer the slots past Size() are poisoned, so reading them is reported as a
+// container-overflow. Define VECTOR_ANNOTATE_CONTAINER=0 to turn the annotations off
+#ifndef VECTOR_ANNOTATE_CONTAINER
+#if defined(__SANITIZE_ADDRESS__)
+#define VECTOR_ANNOTATE_CONTAINER 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define VECTOR_ANNOTATE_CONTAINER 1
+#endif
+#endif
+#endif
+
+#ifndef VECTOR_ANNOTATE_CONTAINER
+#define VECTOR_ANNOTATE_CONTAINER 0
+#endif
+
+#if VECTOR_ANNOTATE_CONTAINER
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+// Customization point: a type is trivially relocatable when moving it to a new address
+// and dropping the source is equivalent to copying its bytes. Specialize it for
+// handle-like types that own resources but do not depend on their own address
 template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {
+};
+
+template <typename T, typename Deleter>
+struct is_trivially_relocatable<std::unique_ptr<T, Deleter>> : is_trivially_relocatable<Deleter> {
+};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+namespace detail {
+
+// True while the vector is being evaluated at compile time, where memcpy, placement new
+// and the allocation statistics are not available
+constexpr bool IsConstantEvaluated() noexcept {
+#if VECTOR_HAS_CONSTEXPR
+    return std::is_constant_evaluated();
+#else
+    return false;
+#endif
+}
+
+// Moves the poisoned boundary of the capacity bytes at begin from old_in_use to new_in_use
+// bytes. AddressSanitizer tracks memory in 8-byte granules, and a block packed next to
+// others (as arena allocators do) may share its first and last granules with them. So
+// blocks that do not start on a granule are left alone, and a partial last granule is
+// never poisoned
+inline void AnnotateContiguousContainer(const void* begin, size_t capacity, size_t old_in_use,
+                                        size_t new_in_use) noexcept {
+#if VECTOR_ANNOTATE_CONTAINER
+    const auto* bytes = static_cast<const char*>(begin);
+    const size_t end = capacity / 8 * 8;
+    old_in_use = std::min(old_in_use, end);
+    new_in_use = std::min(new_in_use, end);
+    if (reinterpret_cast<uintptr_t>(bytes) % 8 == 0 && old_in_use != new_in_use) {
+        __sanitizer_annotate_contiguous_container(bytes, bytes + end, bytes + old_in_use, bytes + new_in_use);
+    }
+#else
+    (void)begin, (void)capacity, (void)old_in_use, (void)new_in_use;
+#endif
+}
+
+template <typename T, typename... Args>
+VECTOR_CONSTEXPR T* ConstructAt(T* p, Args&&... args) {
+#if VECTOR_HAS_CONSTEXPR
+    return std::construct_at(p, std::forward<Args>(args)...);
+#else
+    return new(p) T(std::forward<Args>(args)...);
+#endif
+}
+
+template <typename Allocator, typename T, typename = void>
+struct HasConstruct : std::false_type {
+};
+
+template <typename Allocator, typename T>
+struct HasConstruct<Allocator, T, std::void_t<decltype(std::declval<Allocator&>().construct(
+    std::declval<T*>(), std::declval<T&&>()))>> : std::true_type {
+};
+
+// Allocators with their own construct (polymorphic_allocator passes its memory resource on
+// to the elements) build and destroy every element through allocator_traits. The others take
+// the placement new, std::uninitialized_* and memcpy fast paths
+template <typename Allocator, typename T>
+inline constexpr bool USES_PLAIN_CONSTRUCT = !HasConstruct<Allocator, T>::value;
+
+template <typename Allocator, typename T, typename... Args>
+VECTOR_CONSTEXPR void Construct(Allocator& alloc, T* p, Args&&... args) {
+    if constexpr (USES_PLAIN_CONSTRUCT<Allocator, T>) {
+        ConstructAt(p, std::forward<Args>(args)...);
+    }
+    else {
+        std::allocator_traits<Allocator>::construct(alloc, p, std::forward<Args>(args)...);
+    }
+}
+
+template <typename Allocator, typename T>
+VECTOR_CONSTEXPR void DestroyN(Allocator& alloc, T* p, size_t n) noexcept {
+    if constexpr (USES_PLAIN_CONSTRUCT<Allocator, T>) {
+        std::destroy_n(p, n);
+    }
+    else {
+        for (T* const last = p + n; p != last; ++p) {
+            std::allocator_traits<Allocator>::destroy(alloc, p);
+        }
+    }
+}
+
+// Builds size elements at `to` with make(p, i). If one throws, the built ones are destroyed
+template <typename Allocator, typename T, typename Make>
+VECTOR_CONSTEXPR void UninitializedBuild(Allocator& alloc, T* to, size_t size, Make make) {
+    size_t i = 0;
+    try {
+        for (; i < size; ++i) {
+            make(to + i, i);
+        }
+    }
+    catch (...) {
+        DestroyN(alloc, to, i);
+        throw;
+    }
+}
+
+// Allocators may provide T* Reallocate(T* buf, size_t old_n, size_t new_n) that resizes a
+// block and preserves its bytes, moving it only if it cannot be extended in place
+template <typename Allocator, typename = void>
+struct HasReallocate : std::false_type {
+};
+
+template <typename Allocator>
+struct HasReallocate<Allocator, std::void_t<decltype(std::declval<Allocator&>().Reallocate(
+    std::declval<typename std::allocator_traits<Allocator>::value_type*>(), size_t{}, size_t{}))>>
+    : std::true_type {
+};
+
+// Stats policies that follow individual blocks define OnBlockAllocated(block, bytes),
+// OnBlockFreed(block, bytes) and OnBlockMoved(old_block, new_block, old_bytes, new_bytes),
+// the last for blocks resized by the allocator's Reallocate. They may also define
+// OnRelease(const ReleaseEvent&), called when a vector is destroyed with a block
+template <typename Stats, typename = void>
+struct HasBlockHooks : std::false_type {
+};
+
+template <typename Stats>
+struct HasBlockHooks<Stats, std::void_t<decltype(Stats::OnBlockAllocated(std::declval<const void*>(), size_t{}))>>
+    : std::true_type {
+};
+
+template <typename Stats, typename = void>
+struct HasOnRelease : std::false_type {
+};
+
+template <typename Stats>
+struct HasOnRelease<Stats, std::void_t<decltype(Stats::OnRelease(std::declval<const ReleaseEvent&>()))>>
+    : std::true_type {
+};
+
+}  // namespace detail
+
+template <typename T, typename Allocator = std::allocator<T>, typename Stats = DefaultVectorStats>
 class RawMemory {
+    using AllocTraits = std::allocator_traits<Allocator>;
+
 public:
+    using allocator_type = Allocator;
+
+    // Blocks can be grown without relocating elements one by one
+    static constexpr bool CAN_REALLOCATE = is_trivially_relocatable_v<T> && detail::HasReallocate<Allocator>::value;
+
     RawMemory() = default;
 
-    explicit RawMemory(size_t capacity)
-        : buffer_(Allocate(capacity))
+    VECTOR_CONSTEXPR explicit RawMemory(const Allocator& alloc) noexcept
+        : alloc_(alloc) {
+    }
+
+    VECTOR_CONSTEXPR explicit RawMemory(size_t capacity, const Allocator& alloc = Allocator())
+        : alloc_(alloc)
+        , buffer_(Allocate(capacity))
         , capacity_(capacity) {
+#if VECTOR_ANNOTATE_CONTAINER
+        in_use_ = capacity;
+#endif
     }
 
     RawMemory(const RawMemory&) = delete;
     RawMemory& operator=(const RawMemory& rhs) = delete;
 
-    RawMemory(RawMemory&& other) noexcept {
-        Move(std::move(other));
+    VECTOR_CONSTEXPR RawMemory(RawMemory&& other) noexcept
+        : alloc_(std::move(other.alloc_))
+        , buffer_(std::exchange(other.buffer_, nullptr))
+        , capacity_(std::exchange(other.capacity_, 0)) {
+#if VECTOR_ANNOTATE_CONTAINER
+        in_use_ = std::exchange(other.in_use_, 0);
+#endif
+        other.NextGeneration();
     }
 
-    RawMemory& operator=(RawMemory&& rhs) noexcept {
-        Move(std::move(rhs));
+    // Without propagate_on_container_move_assignment the allocators must compare equal,
+    // otherwise the stolen buffer would be released through the wrong allocator
+    VECTOR_CONSTEXPR RawMemory& operator=(RawMemory&& rhs) noexcept {
+        if (this != &rhs) {
+            Annotate(capacity_);
+            Deallocate(buffer_, capacity_);
+            if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+                alloc_ = std::move(rhs.alloc_);
+            }
+            else {
+                assert(IsAllocatorEqual(rhs));
+            }
+            buffer_ = std::exchange(rhs.buffer_, nullptr);
+            capacity_ = std::exchange(rhs.capacity_, 0);
+#if VECTOR_ANNOTATE_CONTAINER
+            in_use_ = std::exchange(rhs.in_use_, 0);
+#endif
+            NextGeneration();
+            rhs.NextGeneration();
+        }
         return *this;
     }
 
-    ~RawMemory() {
-        Deallocate(buffer_);
+    VECTOR_CONSTEXPR ~RawMemory() {
+        Annotate(capacity_);
+        Deallocate(buffer_, capacity_);
     }
 
-    T* operator+(size_t offset) noexcept {
-        assert(offset <= capacity_);
+    VECTOR_CONSTEXPR T* operator+(size_t offset) noexcept {
+        VECTOR_CHECK(offset <= capacity_);
         return buffer_ + offset;
     }
 
-    const T* operator+(size_t offset) const noexcept {
+    VECTOR_CONSTEXPR const T* operator+(size_t offset) const noexcept {
         return const_cast<RawMemory&>(*this) + offset;
     }
 
-    const T& operator[](size_t index) const noexcept {
+    VECTOR_CONSTEXPR const T& operator[](size_t index) const noexcept {
         return const_cast<RawMemory&>(*this)[index];
     }
 
-    T& operator[](size_t index) noexcept {
-        assert(index < capacity_);
+    VECTOR_CONSTEXPR T& operator[](size_t index) noexcept {
+        VECTOR_CHECK(index < capacity_);
         return buffer_[index];
     }
 
-    void Swap(RawMemory& other) noexcept {
+    // Allocators are exchanged only when the traits ask for it; otherwise they must be equal
+    VECTOR_CONSTEXPR void Swap(RawMemory& other) noexcept {
+        if constexpr (AllocTraits::propagate_on_container_swap::value) {
+            using std::swap;
+            swap(alloc_, other.alloc_);
+        }
+        else {
+            assert(IsAllocatorEqual(other));
+        }
         std::swap(buffer_, other.buffer_);
         std::swap(capacity_, other.capacity_);
+#if VECTOR_ANNOTATE_CONTAINER
+        std::swap(in_use_, other.in_use_);
+#endif
+        NextGeneration();
+        other.NextGeneration();
     }
 
-    const T* GetAddress() const noexcept {
+    // Changes the capacity keeping the bytes of the first min(capacity, new_capacity) slots.
+    // On failure the block is left untouched
+    void Reallocate(size_t new_capacity) {
+        static_assert(CAN_REALLOCATE, "allocator cannot reallocate blocks of T");
+        Annotate(capacity_);
+        if (new_capacity == 0) {
+            Deallocate(buffer_, capacity_);
+            buffer_ = nullptr;
+        }
+        else if (buffer_ == nullptr) {
+            buffer_ = Allocate(new_capacity);
+        }
+        else {
+            // The old block may be freed by the call, so only its address is kept
+            const uintptr_t old_address = reinterpret_cast<uintptr_t>(buffer_);
+            buffer_ = alloc_.Reallocate(buffer_, capacity_, new_capacity);
+            Stats::OnAllocate(new_capacity * sizeof(T));
+            if constexpr (detail::HasBlockHooks<Stats>::value) {
+                Stats::OnBlockMoved(reinterpret_cast<const void*>(old_address), buffer_, capacity_ * sizeof(T),
+                                    new_capacity * sizeof(T));
+            }
+        }
+        capacity_ = new_capacity;
+#if VECTOR_ANNOTATE_CONTAINER
+        in_use_ = new_capacity;
+#endif
+        NextGeneration();
+    }
+
+    // Replaces the allocator of an empty block (used for propagate_on_container_copy_assignment)
+    void AssignAllocator(const Allocator& alloc) {
+        assert(buffer_ == nullptr);
+        alloc_ = alloc;
+    }
+
+    VECTOR_CONSTEXPR bool IsAllocatorEqual(const RawMemory& other) const noexcept {
+        if constexpr (AllocTraits::is_always_equal::value) {
+            return true;
+        }
+        else {
+            return alloc_ == other.alloc_;
+        }
+    }
+
+    VECTOR_CONSTEXPR const Allocator& GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+    // Elements are constructed and destroyed through the allocator, which needs it mutable
+    VECTOR_CONSTEXPR Allocator& GetAllocator() noexcept {
+        return alloc_;
+    }
+
+    VECTOR_CONSTEXPR const T* GetAddress() const noexcept {
         return buffer_;
     }
 
-    T* GetAddress() noexcept {
+    VECTOR_CONSTEXPR T* GetAddress() noexcept {
         return buffer_;
     }
 
-    size_t Capacity() const {
+    VECTOR_CONSTEXPR size_t Capacity() const {
         return capacity_;
     }
 
+    // Declares the first in_use slots as used and poisons the rest for AddressSanitizer.
+    // A new block starts fully usable, and every block is unpoisoned before it is freed
+    VECTOR_CONSTEXPR void Annotate(size_t in_use) noexcept {
+#if VECTOR_ANNOTATE_CONTAINER
+        if (buffer_ != nullptr && in_use != in_use_ && !detail::IsConstantEvaluated()) {
+            detail::AnnotateContiguousContainer(buffer_, capacity_ * sizeof(T), in_use_ * sizeof(T),
+                                                in_use * sizeof(T));
+            in_use_ = in_use;
+        }
+#else
+        (void)in_use;
+#endif
+    }
+
+#if VECTOR_DEBUG_ITERATORS
+    // Changes whenever the block is replaced; debug iterators compare it with their own copy
+    VECTOR_CONSTEXPR const size_t* Generation() const noexcept {
+        return &generation_;
+    }
+#endif
+
 private:
-    void Move(RawMemory&& other) noexcept {
-        Deallocate(buffer_);
-        buffer_ = std::exchange(other.buffer_, nullptr);
-        capacity_ = std::exchange(other.capacity_, 0);
+    // Invalidates the debug iterators into the block
+    VECTOR_CONSTEXPR void NextGeneration() noexcept {
+#if VECTOR_DEBUG_ITERATORS
+        ++generation_;
+#endif
     }
 
-    static T* Allocate(size_t n) {
-        return n != 0 ? static_cast<T*>(operator new(n * sizeof(T))) : nullptr;
+    VECTOR_CONSTEXPR T* Allocate(size_t n) {
+        if (n == 0) {
+            return nullptr;
+        }
+        T* buf = AllocTraits::allocate(alloc_, n);
+        if (!detail::IsConstantEvaluated()) {
+            Stats::OnAllocate(n * sizeof(T));
+            if constexpr (detail::HasBlockHooks<Stats>::value) {
+                Stats::OnBlockAllocated(buf, n * sizeof(T));
+            }
+        }
+        return buf;
     }
 
-    static void Deallocate(T* buf) noexcept {
-        operator delete(buf);
+    VECTOR_CONSTEXPR void Deallocate(T* buf, size_t n) noexcept {
+        if (buf != nullptr) {
+            // The hook is told while the block is still allocated
+            if constexpr (detail::HasBlockHooks<Stats>::value) {
+                if (!detail::IsConstantEvaluated()) {
+                    Stats::OnBlockFreed(buf, n * sizeof(T));
+                }
+            }
+            AllocTraits::deallocate(alloc_, buf, n);
+        }
     }
 
+    Allocator alloc_;
     T* buffer_ = nullptr;
     size_t capacity_ = 0;
+#if VECTOR_DEBUG_ITERATORS
+    size_t generation_ = 0;
+#endif
+#if VECTOR_ANNOTATE_CONTAINER
+    // Slots declared in use; the rest of the block is poisoned
+    size_t in_use_ = 0;
+#endif
+};
+
+// Geometric growth: capacity is multiplied by FactorNum / FactorDen, starting from MinCapacity.
+// MaxStepBytes (when non-zero) caps how many bytes a single growth step may add.
+// RoundBytes (when non-zero) rounds capacities of at least RoundBytes bytes up to its multiple
+// (for example 2 MiB huge pages) and smaller ones up to power-of-two byte size classes
+template <size_t FactorNum = 2, size_t FactorDen = 1, size_t MinCapacity = 1, size_t MaxStepBytes = 0,
+          size_t RoundBytes = 0>
+struct GeometricGrowth {
+    static_assert(FactorDen > 0 && FactorNum > FactorDen, "growth factor must be greater than 1");
+    static_assert(MinCapacity > 0, "first allocation must hold at least one element");
+
+    // Returns a capacity of at least `required` elements when `capacity` is exhausted
+    static constexpr size_t NextCapacity(size_t capacity, size_t required, size_t elem_size) noexcept {
+        const size_t max_capacity = static_cast<size_t>(-1) / elem_size;
+        size_t next = MinCapacity;
+        if (capacity != 0) {
+            next = capacity <= max_capacity / FactorNum ? capacity * FactorNum / FactorDen : max_capacity;
+        }
+        if constexpr (MaxStepBytes != 0) {
+            const size_t max_step = std::max<size_t>(MaxStepBytes / elem_size, 1);
+            if (next - capacity > max_step) {
+                next = capacity + max_step;
+            }
+        }
+        next = std::max({next, required, capacity + 1});
+        if constexpr (RoundBytes != 0) {
+            next = RoundUp(next, elem_size, max_capacity);
+        }
+        return next;
+    }
+
+private:
+    static constexpr size_t RoundUp(size_t n, size_t elem_size, size_t max_capacity) noexcept {
+        if (n > max_capacity / 2) {
+            return n;
+        }
+        const size_t bytes = n * elem_size;
+        size_t rounded = 0;
+        if (bytes >= RoundBytes) {
+            rounded = (bytes + RoundBytes - 1) / RoundBytes * RoundBytes;
+        }
+        else {
+            rounded = 1;
+            while (rounded < bytes) {
+                rounded *= 2;
+            }
+        }
+        return std::max(n, rounded / elem_size);
+    }
+};
+
+using DefaultGrowth = GeometricGrowth<>;
+
+// 1.5x growth for memory-sensitive services; small vectors start with 16 slots
+using CompactGrowth = GeometricGrowth<3, 2, 16>;
+
+// Large buffers are sized in whole 2 MiB pages and grow by at most 1 GiB per step
+using HugePageGrowth = GeometricGrowth<2, 1, 16, size_t{1} << 30, size_t{2} << 20>;
+
+// Adds hysteresis to a growth policy: capacity is halved once size falls below a quarter of it
+template <typename Base = DefaultGrowth>
+struct HysteresisGrowth : Base {
+    static constexpr size_t ShrinkCapacity(size_t capacity, size_t size, size_t /*elem_size*/) noexcept {
+        return size < capacity / 4 ? capacity / 2 : capacity;
+    }
+};
+
+namespace detail {
+
+// Growth policies may define ShrinkCapacity(capacity, size, elem_size) returning the capacity
+// a vector drops to after it has shrunk to size elements
+template <typename Growth, typename = void>
+struct HasShrinkCapacity : std::false_type {
+};
+
+template <typename Growth>
+struct HasShrinkCapacity<Growth, std::void_t<decltype(Growth::ShrinkCapacity(size_t{}, size_t{}, size_t{}))>>
+    : std::true_type {
+};
+
+// std::uninitialized_value_construct_n and std::uninitialized_copy_n are not constexpr,
+// so constant evaluation builds the elements one by one (nothing can throw there)
+template <typename Allocator, typename T>
+VECTOR_CONSTEXPR void UninitializedValueConstruct(Allocator& alloc, T* to, size_t size) {
+    if constexpr (!USES_PLAIN_CONSTRUCT<Allocator, T>) {
+        UninitializedBuild(alloc, to, size, [&alloc](T* p, size_t /*i*/) {
+            Construct(alloc, p);
+        });
+    }
+    else if (IsConstantEvaluated()) {
+        for (size_t i = 0; i < size; ++i) {
+            ConstructAt(to + i);
+        }
+    }
+    else {
+        std::uninitialized_value_construct_n(to, size);
+    }
+}
+
+// allocator_traits can only value-initialize, so allocators with their own construct do that
+template <typename Allocator, typename T>
+void UninitializedDefaultConstruct(Allocator& alloc, T* to, size_t size) {
+    if constexpr (USES_PLAIN_CONSTRUCT<Allocator, T>) {
+        std::uninitialized_default_construct_n(to, size);
+    }
+    else {
+        UninitializedValueConstruct(alloc, to, size);
+    }
+}
+
+template <typename Allocator, typename It, typename T>
+VECTOR_CONSTEXPR void UninitializedCopy(Allocator& alloc, It from, size_t size, T* to) {
+    if (!USES_PLAIN_CONSTRUCT<Allocator, T> || IsConstantEvaluated()) {
+        UninitializedBuild(alloc, to, size, [&alloc, &from](T* p, size_t /*i*/) {
+            Construct(alloc, p, *from);
+            ++from;
+        });
+    }
+    else {
+        std::uninitialized_copy_n(from, size, to);
+    }
+}
+
+template <typename Allocator, typename T>
+void UninitializedFill(Allocator& alloc, T* to, size_t size, const T& value) {
+    if constexpr (USES_PLAIN_CONSTRUCT<Allocator, T>) {
+        std::uninitialized_fill_n(to, size, value);
+    }
+    else {
+        UninitializedBuild(alloc, to, size, [&alloc, &value](T* p, size_t /*i*/) {
+            Construct(alloc, p, value);
+        });
+    }
+}
+
+template <typename Allocator, typename T>
+void UninitializedMove(Allocator& alloc, T* from, size_t size, T* to) {
+    if constexpr (USES_PLAIN_CONSTRUCT<Allocator, T>) {
+        std::uninitialized_move_n(from, size, to);
+    }
+    else {
+        UninitializedBuild(alloc, to, size, [&alloc, from](T* p, size_t i) {
+            Construct(alloc, p, std::move(from[i]));
+        });
+    }
+}
+
+// Constructs copies of size elements at `to`, moving them when that cannot throw
+// (or when T cannot be copied). The source elements are left alive
+template <typename Allocator, typename T>
+VECTOR_CONSTEXPR void UninitializedMoveIfNoexcept(Allocator& alloc, T* from, size_t size, T* to) {
+    constexpr bool MOVES = std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>;
+    if (!USES_PLAIN_CONSTRUCT<Allocator, T> || IsConstantEvaluated()) {
+        UninitializedBuild(alloc, to, size, [&alloc, from](T* p, size_t i) {
+            if constexpr (MOVES) {
+                Construct(alloc, p, std::move(from[i]));
+            }
+            else {
+                Construct(alloc, p, std::as_const(from[i]));
+            }
+        });
+    }
+    else if constexpr (MOVES) {
+        std::uninitialized_move_n(from, size, to);
+    }
+    else {
+        std::uninitialized_copy_n(from, size, to);
+    }
+}
+
+template <typename T>
+VECTOR_CONSTEXPR void UninitializedMoveIfNoexcept(T* from, size_t size, T* to) {
+    std::allocator<T> alloc;
+    UninitializedMoveIfNoexcept(alloc, from, size, to);
+}
+
+// Relocates size elements into raw memory at `to`, leaving `from` as raw memory.
+// Trivially relocatable elements are copied bytewise whatever the allocator
+template <typename Allocator, typename T>
+VECTOR_CONSTEXPR void CopyOrMove(Allocator& alloc, T* from, size_t size, T* to) {
+    if constexpr (is_trivially_relocatable_v<T>) {
+        if (IsConstantEvaluated()) {
+            UninitializedMoveIfNoexcept(alloc, from, size, to);
+            DestroyN(alloc, from, size);
+        }
+        else if (size != 0) {
+            std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), size * sizeof(T));
+        }
+    }
+    else {
+        UninitializedMoveIfNoexcept(alloc, from, size, to);
+        DestroyN(alloc, from, size);
+    }
+}
+
+template <typename T>
+VECTOR_CONSTEXPR void CopyOrMove(T* from, size_t size, T* to) {
+    std::allocator<T> alloc;
+    CopyOrMove(alloc, from, size, to);
+}
+
+// Relocates the size elements of `from` into `to` leaving a gap of `gap` already built
+// elements at to[index]. On failure `from` is left intact and the gap is destroyed
+template <typename Allocator, typename T>
+void RelocateAround(Allocator& alloc, T* from, size_t size, size_t index, size_t gap, T* to) {
+    if constexpr (is_trivially_relocatable_v<T>) {
+        CopyOrMove(alloc, from, index, to);
+        CopyOrMove(alloc, from + index, size - index, to + (index + gap));
+    }
+    else {
+        try {
+            UninitializedMoveIfNoexcept(alloc, from, index, to);
+        }
+        catch (...) {
+            DestroyN(alloc, to + index, gap);
+            throw;
+        }
+
+        try {
+            UninitializedMoveIfNoexcept(alloc, from + index, size - index, to + (index + gap));
+        }
+        catch (...) {
+            DestroyN(alloc, to, index + gap);
+            throw;
+        }
+        DestroyN(alloc, from, size);
+    }
+}
+
+// Builds the element at to[index] and relocates the size elements of `from` around it.
+// On failure `from` is left intact and `to` holds no elements
+template <typename Allocator, typename T, typename... Args>
+void EmplaceRelocating(Allocator& alloc, T* from, size_t size, size_t index, T* to, Args&&... args) {
+    Construct(alloc, to + index, std::forward<Args>(args)...);
+    RelocateAround(alloc, from, size, index, 1, to);
+}
+
+template <typename T, typename... Args>
+void EmplaceRelocating(T* from, size_t size, size_t index, T* to, Args&&... args) {
+    std::allocator<T> alloc;
+    EmplaceRelocating(alloc, from, size, index, to, std::forward<Args>(args)...);
+}
+
+template <typename It>
+using IteratorCategory = typename std::iterator_traits<It>::iterator_category;
+
+template <typename It, typename = void>
+struct IsInputIterator : std::false_type {
+};
+
+template <typename It>
+struct IsInputIterator<It, std::void_t<IteratorCategory<It>>>
+    : std::is_convertible<IteratorCategory<It>, std::input_iterator_tag> {
 };
 
+template <typename It>
+inline constexpr bool IS_FORWARD_ITERATOR = std::is_convertible_v<IteratorCategory<It>, std::forward_iterator_tag>;
+
+// Vector iterator of the debug-iterator mode: a pointer plus the generation of the buffer it
+// was taken from. Moving, swapping or reallocating the buffer bumps the generation, so the
+// check is conservative: an iterator into a moved or swapped vector traps as well.
+// It converts to T* implicitly, so code written against raw pointer iterators still builds
 template <typename T>
+class CheckedIterator {
+    template <typename Int>
+    using EnableIfIntegral = std::enable_if_t<std::is_integral_v<Int>, int>;
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_cv_t<T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    CheckedIterator() = default;
+
+    constexpr CheckedIterator(T* ptr, const size_t* generation) noexcept
+        : ptr_(ptr)
+        , generation_(generation)
+        , expected_(*generation) {
+    }
+
+    // A mutable iterator converts to a const one
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+    constexpr CheckedIterator(const CheckedIterator<U>& other) noexcept
+        : ptr_(other.ptr_)
+        , generation_(other.generation_)
+        , expected_(other.expected_) {
+    }
+
+    constexpr operator T*() const noexcept {
+        Check();
+        return ptr_;
+    }
+
+    constexpr reference operator*() const noexcept {
+        Check();
+        return *ptr_;
+    }
+
+    constexpr pointer operator->() const noexcept {
+        Check();
+        return ptr_;
+    }
+
+    template <typename Int, EnableIfIntegral<Int> = 0>
+    constexpr reference operator[](Int offset) const noexcept {
+        Check();
+        return ptr_[offset];
+    }
+
+    constexpr CheckedIterator& operator++() noexcept {
+        ++ptr_;
+        return *this;
+    }
+
+    constexpr CheckedIterator operator++(int) noexcept {
+        CheckedIterator old = *this;
+        ++ptr_;
+        return old;
+    }
+
+    constexpr CheckedIterator& operator--() noexcept {
+        --ptr_;
+        return *this;
+    }
+
+    constexpr CheckedIterator operator--(int) noexcept {
+        CheckedIterator old = *this;
+        --ptr_;
+        return old;
+    }
+
+    // Integer offsets are templates so that they beat the built-in T* arithmetic reached
+    // through the conversion operator
+    template <typename Int, EnableIfIntegral<Int> = 0>
+    constexpr CheckedIterator& operator+=(Int offset) noexcept {
+        ptr_ += offset;
+        return *this;
+    }
+
+    template <typename Int, EnableIfIntegral<Int> = 0>
+    constexpr CheckedIterator& operator-=(Int offset) noexcept {
+        ptr_ -= offset;
+        return *this;
+    }
+
+    template <typename Int, EnableIfIntegral<Int> = 0>
+    friend constexpr CheckedIterator operator+(CheckedIterator it, Int offset) noexcept {
+        return it += offset;
+    }
+
+    template <typename Int, EnableIfIntegral<Int> = 0>
+    friend constexpr CheckedIterator operator+(Int offset, CheckedIterator it) noexcept {
+        return it += offset;
+    }
+
+    template <typename Int, EnableIfIntegral<Int> = 0>
+    friend constexpr CheckedIterator operator-(CheckedIterator it, Int offset) noexcept {
+        return it -= offset;
+    }
+
+    // Vector positions are computed this way, so a stale pos passed to Insert or Erase traps
+    friend constexpr difference_type operator-(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        lhs.Check();
+        rhs.Check();
+        return lhs.ptr_ - rhs.ptr_;
+    }
+
+    friend constexpr bool operator==(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return lhs.ptr_ == rhs.ptr_;
+    }
+
+    friend constexpr bool operator!=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return lhs.ptr_ != rhs.ptr_;
+    }
+
+    friend constexpr bool operator<(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return lhs.ptr_ < rhs.ptr_;
+    }
+
+    friend constexpr bool operator>(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return lhs.ptr_ > rhs.ptr_;
+    }
+
+    friend constexpr bool operator<=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return lhs.ptr_ <= rhs.ptr_;
+    }
+
+    friend constexpr bool operator>=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return lhs.ptr_ >= rhs.ptr_;
+    }
+
+private:
+    template <typename U>
+    friend class CheckedIterator;
+
+    constexpr void Check() const noexcept {
+        VECTOR_CHECK(generation_ == nullptr || *generation_ == expected_);
+    }
+
+    T* ptr_ = nullptr;
+    const size_t* generation_ = nullptr;
+    size_t expected_ = 0;
+};
+
+// Inserts an element at data[index] shifting the tail right by one slot.
+// There must be room for size + 1 elements and index must be less than size
+template <typename Allocator, typename T, typename... Args>
+void EmplaceShifting(Allocator& alloc, T* data, size_t size, size_t index, Args&&... args) {
+    if constexpr (USES_PLAIN_CONSTRUCT<Allocator, T>) {
+        T temp_elem(std::forward<Args>(args)...);
+        new(data + size) T(std::move(data[size - 1]));
+        std::move_backward(data + index, data + (size - 1), data + size);
+        data[index] = std::move(temp_elem);
+    }
+    else {
+        // The element is built by the allocator in the spare slot and rotated into place
+        Construct(alloc, data + size, std::forward<Args>(args)...);
+        std::rotate(data + index, data + size, data + (size + 1));
+    }
+}
+
+template <typename T, typename... Args>
+void EmplaceShifting(T* data, size_t size, size_t index, Args&&... args) {
+    std::allocator<T> alloc;
+    EmplaceShifting(alloc, data, size, index, std::forward<Args>(args)...);
+}
+
+// Copy-assigns src_size elements over the size elements of data, constructing or destroying
+// the difference. There must be room for src_size elements
+template <typename Allocator, typename T>
+void AssignWithinCapacity(Allocator& alloc, T* data, size_t size, const T* src, size_t src_size) {
+    size_t copy_elem = src_size < size ? src_size : size;
+    auto end = std::copy_n(src, copy_elem, data);
+    if (src_size < size) {
+        DestroyN(alloc, end, size - src_size);
+    }
+    else {
+        UninitializedCopy(alloc, src + size, src_size - size, end);
+    }
+}
+
+template <typename T>
+void AssignWithinCapacity(T* data, size_t size, const T* src, size_t src_size) {
+    std::allocator<T> alloc;
+    AssignWithinCapacity(alloc, data, size, src, src_size);
+}
+
+// Removes count elements starting at data[index] shifting the tail left in one pass.
+// Trivially relocatable tails are moved with memmove after the erased elements are destroyed
+template <typename Allocator, typename T>
+void EraseShifting(Allocator& alloc, T* data, size_t size, size_t index, size_t count = 1)
+    noexcept(std::is_nothrow_move_assignable_v<T>) {
+    if constexpr (is_trivially_relocatable_v<T>) {
+        DestroyN(alloc, data + index, count);
+        std::memmove(static_cast<void*>(data + index), static_cast<const void*>(data + (index + count)),
+                     (size - index - count) * sizeof(T));
+    }
+    else {
+        std::move(data + (index + count), data + size, data + index);
+        DestroyN(alloc, data + (size - count), count);
+    }
+}
+
+template <typename T>
+void EraseShifting(T* data, size_t size, size_t index, size_t count = 1)
+    noexcept(std::is_nothrow_move_assignable_v<T>) {
+    std::allocator<T> alloc;
+    EraseShifting(alloc, data, size, index, count);
+}
+
+}  // namespace detail
+
+// Tag selecting default-initialization of new elements: trivial types are left
+// uninitialized instead of being zero-filled
+struct default_init_t {
+    explicit default_init_t() = default;
+};
+
+inline constexpr default_init_t default_init{};
+
+// Tag selecting the overloads that split construction, copying, relocation and destruction
+// across threads. num_threads == 0 means one thread per hardware core
+struct parallel_t {
+    explicit constexpr parallel_t(size_t num_threads = 0) noexcept
+        : num_threads(num_threads) {
+    }
+
+    size_t num_threads;
+};
+
+inline constexpr parallel_t parallel{};
+
+namespace detail {
+
+// Chunks smaller than this are not worth a thread
+inline constexpr size_t PARALLEL_MIN_CHUNK = size_t{1} << 14;
+
+// Splits [0, n) into contiguous chunks and runs op(first, count) on them concurrently.
+// If any chunk throws, undo(first, count) is called for every chunk that succeeded and the
+// first exception is rethrown, so either all of [0, n) is processed or none of it
+template <typename Operation, typename Undo>
+void ParallelChunks(parallel_t policy, size_t n, Operation op, Undo undo) {
+    const size_t num_threads = policy.num_threads != 0
+                                   ? policy.num_threads
+                                   : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    const size_t num_chunks = std::clamp<size_t>(n / PARALLEL_MIN_CHUNK, 1, num_threads);
+    if (num_chunks == 1) {
+        op(size_t{0}, n);
+        return;
+    }
+    auto chunk_begin = [n, num_chunks](size_t chunk) {
+        return n / num_chunks * chunk + std::min(chunk, n % num_chunks);
+    };
+    std::unique_ptr<std::exception_ptr[]> errors(new std::exception_ptr[num_chunks]);
+    std::unique_ptr<std::thread[]> threads(new std::thread[num_chunks]);
+    auto run = [&](size_t chunk) noexcept {
+        try {
+            op(chunk_begin(chunk), chunk_begin(chunk + 1) - chunk_begin(chunk));
+        }
+        catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+
+    size_t started = 1;
+    try {
+        for (; started < num_chunks; ++started) {
+            threads[started] = std::thread(run, started);
+        }
+    }
+    catch (...) {
+        // Chunks that did not get a thread run on this one
+    }
+    run(0);
+    for (size_t chunk = started; chunk < num_chunks; ++chunk) {
+        run(chunk);
+    }
+    for (size_t chunk = 1; chunk < started; ++chunk) {
+        threads[chunk].join();
+    }
+
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        if (errors[chunk]) {
+            for (size_t done = 0; done < num_chunks; ++done) {
+                if (!errors[done]) {
+                    undo(chunk_begin(done), chunk_begin(done + 1) - chunk_begin(done));
+                }
+            }
+            std::rethrow_exception(errors[chunk]);
+        }
+    }
+}
+
+// Allocators with their own construct are called from the calling thread only,
+// since memory resources need not be thread-safe
+
+template <typename Allocator, typename T>
+void ParallelDestroy(parallel_t policy, Allocator& alloc, T* data, size_t n) noexcept {
+    if constexpr (!USES_PLAIN_CONSTRUCT<Allocator, T>) {
+        DestroyN(alloc, data, n);
+    }
+    else if constexpr (!std::is_trivially_destructible_v<T>) {
+        auto destroy = [data](size_t first, size_t count) {
+            std::destroy_n(data + first, count);
+        };
+        try {
+            ParallelChunks(policy, n, destroy, [](size_t, size_t) {});
+        }
+        catch (...) {
+            // Only the bookkeeping can fail, and it does so before any element is touched
+            destroy(0, n);
+        }
+    }
+}
+
+template <typename Allocator, typename T>
+void ParallelUninitializedValueConstruct(parallel_t policy, Allocator& alloc, T* data, size_t n) {
+    if constexpr (!USES_PLAIN_CONSTRUCT<Allocator, T>) {
+        UninitializedValueConstruct(alloc, data, n);
+        return;
+    }
+    ParallelChunks(policy, n,
+        [data](size_t first, size_t count) {
+            std::uninitialized_value_construct_n(data + first, count);
+        },
+        [data](size_t first, size_t count) {
+            std::destroy_n(data + first, count);
+        });
+}
+
+template <typename Allocator, typename T>
+void ParallelUninitializedCopy(parallel_t policy, Allocator& alloc, const T* from, size_t n, T* to) {
+    if constexpr (!USES_PLAIN_CONSTRUCT<Allocator, T>) {
+        UninitializedCopy(alloc, from, n, to);
+        return;
+    }
+    ParallelChunks(policy, n,
+        [from, to](size_t first, size_t count) {
+            std::uninitialized_copy_n(from + first, count, to + first);
+        },
+        [to](size_t first, size_t count) {
+            std::destroy_n(to + first, count);
+        });
+}
+
+// Parallel CopyOrMove: relocates n elements, leaving `from` intact if it fails
+template <typename Allocator, typename T>
+void ParallelCopyOrMove(parallel_t policy, Allocator& alloc, T* from, size_t n, T* to) {
+    if constexpr (!USES_PLAIN_CONSTRUCT<Allocator, T>) {
+        CopyOrMove(alloc, from, n, to);
+        return;
+    }
+    ParallelChunks(policy, n,
+        [from, to](size_t first, size_t count) {
+            if constexpr (is_trivially_relocatable_v<T>) {
+                CopyOrMove(from + first, count, to + first);
+            }
+            else {
+                UninitializedMoveIfNoexcept(from + first, count, to + first);
+            }
+        },
+        [to](size_t first, size_t count) {
+            if constexpr (!is_trivially_relocatable_v<T>) {
+                std::destroy_n(to + first, count);
+            }
+        });
+    if constexpr (!is_trivially_relocatable_v<T>) {
+        ParallelDestroy(policy, alloc, from, n);
+    }
+}
+
+}  // namespace detail
+
+template <typename T, typename Allocator = std::allocator<T>, typename Growth = DefaultGrowth,
+          typename Stats = DefaultVectorStats>
 class Vector {
+    using AllocTraits = std::allocator_traits<Allocator>;
+    using Memory = RawMemory<T, Allocator, Stats>;
+
+    // Copy-assignment keeps the existing elements alive across growth when relocating them is
+    // cheap and assigning to them can reuse what they own
+    static constexpr bool REUSES_ELEMENTS_ON_ASSIGN = !std::is_trivially_copyable_v<T>
+                                                      && (is_trivially_relocatable_v<T>
+                                                          || std::is_nothrow_move_constructible_v<T>);
+
 public:
+    using value_type = T;
+    using allocator_type = Allocator;
+#if VECTOR_DEBUG_ITERATORS
+    using iterator = detail::CheckedIterator<T>;
+    using const_iterator = detail::CheckedIterator<const T>;
+#else
     using iterator = T*;
     using const_iterator = const T*;
+#endif
 
-    iterator begin() noexcept {
-        return data_.GetAddress();
+    VECTOR_CONSTEXPR iterator begin() noexcept {
+        return MakeIterator(data_.GetAddress());
     }
 
-    iterator end() noexcept {
-        return data_ + size_;
+    VECTOR_CONSTEXPR iterator end() noexcept {
+        return MakeIterator(data_ + size_);
     }
 
-    const_iterator begin() const noexcept {
-        return data_.GetAddress();
+    VECTOR_CONSTEXPR const_iterator begin() const noexcept {
+        return MakeIterator(data_.GetAddress());
     }
 
-    const_iterator end() const noexcept {
-        return data_ + size_;
+    VECTOR_CONSTEXPR const_iterator end() const noexcept {
+        return MakeIterator(data_ + size_);
+    }
+
+    VECTOR_CONSTEXPR const_iterator cbegin() const noexcept {
+        return begin();
     }
 
-    const_iterator cbegin() const noexcept {
+    VECTOR_CONSTEXPR const_iterator cend() const noexcept {
+        return end();
+    }
+
+    // Address of the elements; unlike begin() it is a raw pointer in every iterator mode
+    VECTOR_CONSTEXPR T* Data() noexcept {
         return data_.GetAddress();
     }
 
-    const_iterator cend() const noexcept {
-        return data_ + size_;
+    VECTOR_CONSTEXPR const T* Data() const noexcept {
+        return data_.GetAddress();
     }
 
     Vector() = default;
 
-    explicit Vector(size_t size)
-        : data_(size),
+    VECTOR_CONSTEXPR explicit Vector(const Allocator& alloc) noexcept
+        : data_(alloc)
+    {
+    }
+
+    VECTOR_CONSTEXPR explicit Vector(size_t size, const Allocator& alloc = Allocator())
+        : data_(size, alloc),
         size_(size)
     {
-        std::uninitialized_value_construct_n(data_.GetAddress(), size);
+        detail::UninitializedValueConstruct(data_.GetAllocator(), data_.GetAddress(), size);
     }
 
-    Vector(const Vector& other)
-        : data_(other.size_),
+    Vector(size_t size, default_init_t, const Allocator& alloc = Allocator())
+        : data_(size, alloc),
+        size_(size)
+    {
+        detail::UninitializedDefaultConstruct(data_.GetAllocator(), data_.GetAddress(), size);
+    }
+
+    template <typename InputIt, typename = std::enable_if_t<detail::IsInputIterator<InputIt>::value>>
+    Vector(InputIt first, InputIt last, const Allocator& alloc = Allocator())
+        : Vector(alloc)
+    {
+        Append(first, last);
+    }
+
+    Vector(parallel_t policy, size_t size, const Allocator& alloc = Allocator())
+        : data_(size, alloc),
+        size_(size)
+    {
+        detail::ParallelUninitializedValueConstruct(policy, data_.GetAllocator(), data_.GetAddress(), size);
+    }
+
+    Vector(parallel_t policy, const Vector& other)
+        : data_(other.size_, AllocTraits::select_on_container_copy_construction(other.GetAllocator())),
         size_(other.size_)
     {
-        std::uninitialized_copy_n(other.data_.GetAddress(), size_, data_.GetAddress());
+        detail::ParallelUninitializedCopy(policy, data_.GetAllocator(), other.data_.GetAddress(), size_,
+                                          data_.GetAddress());
     }
 
-    Vector(Vector<T>&& other) noexcept {
-        data_ = std::move(other.data_);
-        size_ = std::exchange(other.size_, 0);
+    VECTOR_CONSTEXPR Vector(const Vector& other)
+        : Vector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator()))
+    {
+    }
+
+    VECTOR_CONSTEXPR Vector(const Vector& other, const Allocator& alloc)
+        : data_(other.size_, alloc),
+        size_(other.size_)
+    {
+        detail::UninitializedCopy(data_.GetAllocator(), other.data_.GetAddress(), size_, data_.GetAddress());
     }
 
-    Vector<T>& operator=(const Vector<T>& rhs) {
+    VECTOR_CONSTEXPR Vector(Vector&& other) noexcept
+        : data_(std::move(other.data_)),
+        size_(std::exchange(other.size_, 0))
+    {
+    }
+
+    // Steals the buffer when the allocators are equal, otherwise moves element by element
+    Vector(Vector&& other, const Allocator& alloc)
+        : data_(alloc)
+    {
+        if (data_.IsAllocatorEqual(other.data_)) {
+            data_.Swap(other.data_);
+            size_ = std::exchange(other.size_, 0);
+        }
+        else {
+            Memory new_data(other.size_, alloc);
+            detail::UninitializedMove(new_data.GetAllocator(), other.data_.GetAddress(), other.size_,
+                                      new_data.GetAddress());
+            data_.Swap(new_data);
+            size_ = other.size_;
+        }
+    }
+
+    Vector& operator=(const Vector& rhs) {
         if (this != &rhs) {
-            if (rhs.size_ > data_.Capacity()) {
-                Vector copy(rhs);
-                Swap(copy);
+            if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+                if (!data_.IsAllocatorEqual(rhs.data_)) {
+                    // Memory owned by the old allocator has to be released before it is replaced
+                    detail::DestroyN(data_.GetAllocator(), data_.GetAddress(), size_);
+                    size_ = 0;
+                    Memory(GetAllocator()).Swap(data_);
+                    data_.AssignAllocator(rhs.GetAllocator());
+                }
             }
-            else {
-                size_t copy_elem = rhs.size_ < size_ ? rhs.size_ : size_;
-                auto end = std::copy_n(rhs.data_.GetAddress(), copy_elem, data_.GetAddress());
-                if (rhs.size_ < size_) {
-                    std::destroy_n(end, size_ - rhs.size_);
+            if (rhs.size_ > data_.Capacity()) {
+                if constexpr (REUSES_ELEMENTS_ON_ASSIGN) {
+                    // Elements that own buffers (strings, nested vectors) are relocated and
+                    // assigned to, so their buffers are reused instead of being rebuilt
+                    Reserve(rhs.size_);
                 }
                 else {
-                    std::uninitialized_copy_n(rhs.data_.GetAddress() + size_, rhs.size_ - size_, end);
+                    Vector copy(rhs, GetAllocator());
+                    Swap(copy);
+                    return *this;
                 }
-                size_ = rhs.size_;
             }
+            data_.Annotate(std::max(size_, rhs.size_));
+            detail::AssignWithinCapacity(data_.GetAllocator(), data_.GetAddress(), size_, rhs.data_.GetAddress(),
+                                         rhs.size_);
+            size_ = rhs.size_;
+            data_.Annotate(size_);
         }
         return *this;
     }
 
-    Vector<T>& operator=(Vector<T>&& rhs) noexcept {
-        Swap(rhs);
+    Vector& operator=(Vector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                             || AllocTraits::is_always_equal::value) {
+        if (this == &rhs) {
+            return *this;
+        }
+        if (data_.IsAllocatorEqual(rhs.data_)) {
+            Swap(rhs);
+        }
+        else if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+            detail::DestroyN(data_.GetAllocator(), data_.GetAddress(), size_);
+            size_ = 0;
+            data_ = std::move(rhs.data_);
+            size_ = std::exchange(rhs.size_, 0);
+        }
+        else {
+            Vector moved(std::move(rhs), GetAllocator());
+            Swap(moved);
+        }
         return *this;
     }
 
-    ~Vector() {
-        std::destroy_n(data_.GetAddress(), size_);
+    // Move-assigns the elements of source over the elements of this vector. The buffer of this
+    // vector is kept when it is large enough. When T's move assignment swaps storage, as Vector's
+    // does, each element takes over the buffers of its counterpart in source, which in turn keeps
+    // the displaced ones: they can be refilled in place or go back to source's allocator (or pool)
+    // when it is cleared. source keeps its size
+    void AssignFrom(Vector&& source) {
+        if (this == &source) {
+            return;
+        }
+        if (source.size_ > data_.Capacity()) {
+            Reserve(source.size_);
+        }
+        T* from = source.data_.GetAddress();
+        T* to = data_.GetAddress();
+        data_.Annotate(std::max(size_, source.size_));
+        if (source.size_ <= size_) {
+            std::move(from, from + source.size_, to);
+            detail::DestroyN(data_.GetAllocator(), to + source.size_, size_ - source.size_);
+        }
+        else {
+            std::move(from, from + size_, to);
+            detail::UninitializedMove(data_.GetAllocator(), from + size_, source.size_ - size_, to + size_);
+        }
+        size_ = source.size_;
+        data_.Annotate(size_);
+    }
+
+    VECTOR_CONSTEXPR ~Vector() {
+        if constexpr (detail::HasOnRelease<Stats>::value) {
+            if (data_.Capacity() != 0 && !detail::IsConstantEvaluated()) {
+                ReleaseEvent event;
+                event.block = data_.GetAddress();
+                event.capacity_bytes = data_.Capacity() * sizeof(T);
+                event.size_bytes = size_ * sizeof(T);
+                Stats::OnRelease(event);
+            }
+        }
+        detail::DestroyN(data_.GetAllocator(), data_.GetAddress(), size_);
+    }
+
+    VECTOR_CONSTEXPR Allocator GetAllocator() const noexcept {
+        return data_.GetAllocator();
     }
 
-    void Reserve(size_t new_capacity) {
+    VECTOR_CONSTEXPR void Reserve(size_t new_capacity) {
         if (new_capacity <= data_.Capacity()) {
             return;
         }
-        RawMemory<T> new_data(new_capacity);
-        CopyOrMove(data_.GetAddress(), size_, new_data.GetAddress());
-        data_.Swap(new_data);
+        Relocate(new_capacity);
+    }
+
+    void Reserve(parallel_t policy, size_t new_capacity) {
+        if (new_capacity <= data_.Capacity()) {
+            return;
+        }
+        if constexpr (Memory::CAN_REALLOCATE) {
+            ReallocateBuffer(new_capacity);
+        }
+        else {
+            Memory new_data(new_capacity, data_.GetAllocator());
+            detail::ParallelCopyOrMove(policy, data_.GetAllocator(), data_.GetAddress(), size_,
+                                       new_data.GetAddress());
+            ReplaceBuffer(new_data);
+        }
+    }
+
+    // Releases unused capacity. On failure the vector is left unchanged
+    VECTOR_CONSTEXPR void ShrinkToFit() {
+        if (size_ != data_.Capacity()) {
+            Relocate(size_);
+        }
     }
 
-    size_t Size() const noexcept {
+    VECTOR_CONSTEXPR size_t Size() const noexcept {
         return size_;
     }
 
-    size_t Capacity() const noexcept {
+    VECTOR_CONSTEXPR size_t Capacity() const noexcept {
         return data_.Capacity();
     }
 
-    void Swap(Vector<T>& other) noexcept {
+    VECTOR_CONSTEXPR void Swap(Vector& other) noexcept {
         data_.Swap(other.data_);
         std::swap(size_, other.size_);
     }
 
-    void Resize(size_t new_size) {
+    VECTOR_CONSTEXPR void Resize(size_t new_size) {
         if (new_size < size_) {
-            std::destroy_n(data_.GetAddress() + new_size, size_ - new_size);
+            detail::DestroyN(data_.GetAllocator(), data_.GetAddress() + new_size, size_ - new_size);
+            size_ = new_size;
+            ShrinkByPolicy();
         }
         else if (new_size > size_) {
             Reserve(new_size);
-            std::uninitialized_value_construct_n(data_.GetAddress() + size_, new_size - size_);
+            data_.Annotate(new_size);
+            detail::UninitializedValueConstruct(data_.GetAllocator(), data_.GetAddress() + size_, new_size - size_);
+            size_ = new_size;
         }
-        size_ = new_size;
+        data_.Annotate(size_);
     }
 
-    void PushBack(const T& value) {
-        if (size_ == Capacity()) {
-            RawMemory<T> new_data(size_ == 0 ? 1 : size_ * 2);
-            new(new_data + size_) T(value);
-            CopyOrMove(data_.GetAddress(), size_, new_data.GetAddress());
-            data_.Swap(new_data);
+    void Resize(parallel_t policy, size_t new_size) {
+        if (new_size < size_) {
+            detail::ParallelDestroy(policy, data_.GetAllocator(), data_.GetAddress() + new_size, size_ - new_size);
+            size_ = new_size;
+            ShrinkByPolicy();
         }
-        else {
-            new(data_ + size_)T(value);
+        else if (new_size > size_) {
+            Reserve(policy, new_size);
+            data_.Annotate(new_size);
+            detail::ParallelUninitializedValueConstruct(policy, data_.GetAllocator(), data_.GetAddress() + size_,
+                                                        new_size - size_);
+            size_ = new_size;
         }
-        ++size_;
+        data_.Annotate(size_);
     }
 
-    void PushBack(T&& value) {
-        if (size_ == Capacity()) {
-            RawMemory<T> new_data(size_ == 0 ? 1 : size_ * 2);
-            new(new_data + size_) T(std::move(value));
-            CopyOrMove(data_.GetAddress(), size_, new_data.GetAddress());
-            data_.Swap(new_data);
+    // Same as Resize, but new elements are default-initialized
+    void ResizeDefaultInit(size_t new_size) {
+        if (new_size < size_) {
+            detail::DestroyN(data_.GetAllocator(), data_.GetAddress() + new_size, size_ - new_size);
+            size_ = new_size;
+            ShrinkByPolicy();
         }
-        else {
-            new(data_ + size_)T(std::move(value));
+        else if (new_size > size_) {
+            Reserve(new_size);
+            data_.Annotate(new_size);
+            detail::UninitializedDefaultConstruct(data_.GetAllocator(), data_.GetAddress() + size_, new_size - size_);
+            size_ = new_size;
         }
-        ++size_;
+        data_.Annotate(size_);
     }
 
-    void PopBack() noexcept {
-        assert(size_ > 0);
-        std::destroy_at(data_ + (size_ - 1));
+    // Grows to new_size leaving new elements uninitialized, then calls op(data, new_size) to fill
+    // them. op returns the number of leading elements to keep, which must not exceed new_size.
+    // As with basic_string::resize_and_overwrite, op must not throw
+    template <typename Operation>
+    void ResizeAndOverwrite(size_t new_size, Operation op) {
+        static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+                      "uninitialized elements can be exposed only for trivial types");
+        ResizeDefaultInit(new_size);
+        const auto kept = std::move(op)(data_.GetAddress(), new_size);
+        assert(static_cast<size_t>(kept) <= new_size);
+        size_ = static_cast<size_t>(kept);
+        data_.Annotate(size_);
+    }
+
+    // Makes room for count more elements and returns the first of them, uninitialized. The
+    // caller constructs a prefix of them in place and adds it with CommitAppend; any other
+    // change to the vector in between discards the prepared space. Capacity grows by the
+    // policy, so batched appends reallocate as rarely as PushBack does
+    VECTOR_CONSTEXPR T* PrepareAppend(size_t count) {
+        if (count > data_.Capacity() - size_) {
+            Relocate(NextCapacity(count));
+        }
+        data_.Annotate(size_ + count);
+        return data_ + size_;
+    }
+
+    // Adds the first count elements constructed in the space returned by PrepareAppend
+    VECTOR_CONSTEXPR void CommitAppend(size_t count) noexcept {
+        VECTOR_CHECK(count <= data_.Capacity() - size_);
+        size_ += count;
+        data_.Annotate(size_);
+    }
+
+    VECTOR_CONSTEXPR void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    VECTOR_CONSTEXPR void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    VECTOR_CONSTEXPR void PopBack() noexcept {
+        VECTOR_CHECK(size_ > 0);
+        detail::DestroyN(data_.GetAllocator(), data_ + (size_ - 1), 1);
         --size_;
+        ShrinkByPolicy();
+        data_.Annotate(size_);
     }
 
     template <typename... Args>
-    T& EmplaceBack(Args&&... args) {
+    VECTOR_CONSTEXPR T& EmplaceBack(Args&&... args) {
+        if constexpr (Memory::CAN_REALLOCATE) {
+            if (size_ == Capacity()) {
+                // Arguments may refer to elements, so they are consumed before the block moves
+                T temp(std::forward<Args>(args)...);
+                ReallocateBuffer(NextCapacity());
+                data_.Annotate(size_ + 1);
+                detail::Construct(data_.GetAllocator(), data_ + size_, std::move(temp));
+                ++size_;
+                return data_[size_ - 1];
+            }
+        }
         if (size_ == Capacity()) {
-            RawMemory<T> new_data(size_ == 0 ? 1 : size_ * 2);
-            new(new_data + size_) T(std::forward<Args>(args)...);
-            CopyOrMove(data_.GetAddress(), size_, new_data.GetAddress());
-            data_.Swap(new_data);
+            Memory new_data(NextCapacity(), data_.GetAllocator());
+            detail::Construct(data_.GetAllocator(), new_data + size_, std::forward<Args>(args)...);
+            try {
+                CopyOrMove(data_.GetAddress(), size_, new_data.GetAddress());
+            }
+            catch (...) {
+                detail::DestroyN(data_.GetAllocator(), new_data + size_, 1);
+                throw;
+            }
+            ReplaceBuffer(new_data);
         }
         else {
-            new(data_ + size_)T(std::forward<Args>(args)...);
+            data_.Annotate(size_ + 1);
+            detail::Construct(data_.GetAllocator(), data_ + size_, std::forward<Args>(args)...);
         }
         ++size_;
+        data_.Annotate(size_);
         return data_[size_ - 1];
     }
 
     template <typename... Args>
     iterator Emplace(const_iterator pos, Args&&... args) {
         if (pos == end()) {
-            return &EmplaceBack(std::forward<Args>(args)...);
+            return MakeIterator(&EmplaceBack(std::forward<Args>(args)...));
         }
-        if (size_ == Capacity()) {
-            size_t index = static_cast<size_t>(pos - begin());
-            RawMemory<T> new_data(size_ == 0 ? 1 : size_ * 2);
-            new(new_data + index) T(std::forward<Args>(args)...);
-            try {
-                CopyOrMove(data_.GetAddress(), index, new_data.GetAddress());
-            }
-            catch (...) {
-                new_data[index].~T();
-                throw;
+        if constexpr (Memory::CAN_REALLOCATE) {
+            if (size_ == Capacity()) {
+                size_t index = static_cast<size_t>(pos - begin());
+                T temp(std::forward<Args>(args)...);
+                ReallocateBuffer(NextCapacity());
+                data_.Annotate(size_ + 1);
+                std::memmove(static_cast<void*>(data_ + (index + 1)), static_cast<const void*>(data_ + index),
+                             (size_ - index) * sizeof(T));
+                detail::Construct(data_.GetAllocator(), data_ + index, std::move(temp));
+                ++size_;
+                return begin() + index;
             }
-
-            try {
-                CopyOrMove(data_ + index, size_ - index, new_data + (index + 1));
-            }
-            catch (...) {
-                std::destroy_n(new_data.GetAddress(), index + 1);
-                throw;
-            }
-            data_.Swap(new_data);
-            ++size_;
-            return begin() + index;
+        }
+        size_t index = static_cast<size_t>(pos - begin());
+        if (size_ == Capacity()) {
+            Memory new_data(NextCapacity(), data_.GetAllocator());
+            detail::EmplaceRelocating(data_.GetAllocator(), data_.GetAddress(), size_, index, new_data.GetAddress(),
+                                      std::forward<Args>(args)...);
+            ReplaceBuffer(new_data);
         }
         else {
-            size_t index = static_cast<size_t>(pos - begin());
-            T temp_elem(std::forward<Args>(args)...);
-            new(end()) T(std::move(data_[size_ - 1]));
-            std::move_backward(begin() + index, end() - 1, end());
-            data_[index] = std::move(temp_elem);
-            ++size_;
-            return begin() + index;
+            data_.Annotate(size_ + 1);
+            detail::EmplaceShifting(data_.GetAllocator(), data_.GetAddress(), size_, index,
+                                    std::forward<Args>(args)...);
         }
+        ++size_;
+        data_.Annotate(size_);
+        return begin() + index;
     }
 
     iterator Erase(const_iterator pos) noexcept(std::is_nothrow_move_assignable_v<T>) {
-        assert(size_ > 0);
         size_t index = static_cast<size_t>(pos - begin());
-        std::move(begin() + index + 1, end(), begin() + index);
-        data_[size_ - 1].~T();
+        VECTOR_CHECK(index < size_);
+        detail::EraseShifting(data_.GetAllocator(), data_.GetAddress(), size_, index);
         --size_;
+        ShrinkByPolicy();
+        data_.Annotate(size_);
+        return begin() + index;
+    }
+
+    iterator Erase(const_iterator first, const_iterator last) noexcept(std::is_nothrow_move_assignable_v<T>) {
+        size_t index = static_cast<size_t>(first - begin());
+        size_t count = static_cast<size_t>(last - first);
+        VECTOR_CHECK(index <= size_ && count <= size_ - index);
+        if (count != 0) {
+            detail::EraseShifting(data_.GetAllocator(), data_.GetAddress(), size_, index, count);
+            size_ -= count;
+            ShrinkByPolicy();
+            data_.Annotate(size_);
+        }
         return begin() + index;
     }
 
+    VECTOR_CONSTEXPR void Clear() noexcept {
+        detail::DestroyN(data_.GetAllocator(), data_.GetAddress(), size_);
+        size_ = 0;
+        data_.Annotate(0);
+    }
+
+    void Clear(parallel_t policy) noexcept {
+        detail::ParallelDestroy(policy, data_.GetAllocator(), data_.GetAddress(), size_);
+        size_ = 0;
+        data_.Annotate(0);
+    }
+
     iterator Insert(const_iterator pos, const T& value) {
         return Emplace(pos, value);
     }
@@ -304,25 +1557,216 @@ public:
         return Emplace(pos, std::move(value));
     }
 
-    const T& operator[](size_t index) const noexcept {
+    iterator Insert(const_iterator pos, size_t count, const T& value) {
+        const size_t index = static_cast<size_t>(pos - begin());
+        if (count == 0) {
+            return begin() + index;
+        }
+        // value may refer to an element that is about to be shifted or relocated
+        const T value_copy(value);
+        return InsertN(index, count, [this, &value_copy](T* dest, size_t /*offset*/, size_t n) {
+            detail::UninitializedFill(data_.GetAllocator(), dest, n, value_copy);
+        });
+    }
+
+    // Inserts [first, last) before pos. Forward ranges reallocate at most once and shift
+    // the tail once. The vector is left unchanged if an exception is thrown. The range must
+    // not refer to elements of this vector
+    template <typename InputIt, typename = std::enable_if_t<detail::IsInputIterator<InputIt>::value>>
+    iterator Insert(const_iterator pos, InputIt first, InputIt last) {
+        const size_t index = static_cast<size_t>(pos - begin());
+        if constexpr (detail::IS_FORWARD_ITERATOR<InputIt>) {
+            const auto count = static_cast<size_t>(std::distance(first, last));
+            return InsertN(index, count, [this, first](T* dest, size_t offset, size_t n) {
+                detail::UninitializedCopy(data_.GetAllocator(), std::next(first, offset), n, dest);
+            });
+        }
+        else {
+            const size_t old_size = size_;
+            try {
+                for (; first != last; ++first) {
+                    EmplaceBack(*first);
+                }
+            }
+            catch (...) {
+                detail::DestroyN(data_.GetAllocator(), data_ + old_size, size_ - old_size);
+                size_ = old_size;
+                data_.Annotate(size_);
+                throw;
+            }
+            std::rotate(begin() + index, begin() + old_size, end());
+            return begin() + index;
+        }
+    }
+
+    template <typename InputIt, typename = std::enable_if_t<detail::IsInputIterator<InputIt>::value>>
+    void Append(InputIt first, InputIt last) {
+        Insert(cend(), first, last);
+    }
+
+    template <typename Range>
+    void Append(const Range& range) {
+        using std::begin;
+        using std::end;
+        Append(begin(range), end(range));
+    }
+
+    VECTOR_CONSTEXPR const T& operator[](size_t index) const noexcept {
         return const_cast<Vector&>(*this)[index];
     }
 
-    T& operator[](size_t index) noexcept {
-        assert(index < size_);
+    VECTOR_CONSTEXPR T& operator[](size_t index) noexcept {
+        VECTOR_CHECK(index < size_);
         return data_[index];
     }
 
 private:
+    VECTOR_CONSTEXPR iterator MakeIterator(T* ptr) noexcept {
+#if VECTOR_DEBUG_ITERATORS
+        return iterator(ptr, data_.Generation());
+#else
+        return ptr;
+#endif
+    }
+
+    VECTOR_CONSTEXPR const_iterator MakeIterator(const T* ptr) const noexcept {
+#if VECTOR_DEBUG_ITERATORS
+        return const_iterator(ptr, data_.Generation());
+#else
+        return ptr;
+#endif
+    }
+
+    // Moves the elements into a block of new_capacity >= size_ slots
+    VECTOR_CONSTEXPR void Relocate(size_t new_capacity) {
+        if constexpr (Memory::CAN_REALLOCATE) {
+            ReallocateBuffer(new_capacity);
+        }
+        else {
+            Memory new_data(new_capacity, data_.GetAllocator());
+            CopyOrMove(data_.GetAddress(), size_, new_data.GetAddress());
+            ReplaceBuffer(new_data);
+        }
+    }
 
-    static void CopyOrMove(T* from, size_t size, T* to) {
-        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            std::uninitialized_move_n(from, size, to);
+    // Gives capacity back after removals when the growth policy asks for it.
+    // Shrinking is best effort: if it fails the larger block is kept
+    VECTOR_CONSTEXPR void ShrinkByPolicy() noexcept {
+        if constexpr (detail::HasShrinkCapacity<Growth>::value) {
+            const size_t new_capacity = std::max(Growth::ShrinkCapacity(data_.Capacity(), size_, sizeof(T)), size_);
+            if (new_capacity < data_.Capacity()) {
+                try {
+                    Relocate(new_capacity);
+                }
+                catch (...) {
+                }
+            }
+        }
+    }
+
+    // Installs a block the elements were relocated into; the old block ends up in new_data
+    VECTOR_CONSTEXPR void ReplaceBuffer(Memory& new_data) noexcept {
+        const size_t old_capacity = data_.Capacity();
+        data_.Swap(new_data);
+        data_.Annotate(size_);
+        RecordReallocation(new_data.GetAddress(), old_capacity);
+    }
+
+    void ReallocateBuffer(size_t new_capacity) {
+        const size_t old_capacity = data_.Capacity();
+        // The old block may be freed by Reallocate, so only its address is kept
+        const uintptr_t old_address = reinterpret_cast<uintptr_t>(data_.GetAddress());
+        data_.Reallocate(new_capacity);
+        data_.Annotate(size_);
+        RecordReallocation(reinterpret_cast<const T*>(old_address), old_capacity);
+    }
+
+    // Reports to the stats policy that the size_ elements moved out of old_block of old_capacity.
+    // old_block may already be freed and serves only to identify it
+    VECTOR_CONSTEXPR void RecordReallocation(const T* old_block, size_t old_capacity) const noexcept {
+        if (old_capacity == 0 || detail::IsConstantEvaluated()) {
+            return;
+        }
+        constexpr bool BY_COPY = !is_trivially_relocatable_v<T> && !std::is_nothrow_move_constructible_v<T>
+                                 && std::is_copy_constructible_v<T>;
+        ReallocationEvent event;
+        event.old_block = old_block;
+        event.new_block = data_.GetAddress();
+        event.old_bytes = old_capacity * sizeof(T);
+        event.new_bytes = data_.Capacity() * sizeof(T);
+        (BY_COPY ? event.copied : event.moved) = size_;
+        Stats::OnReallocate(event);
+    }
+
+    VECTOR_CONSTEXPR size_t NextCapacity(size_t count = 1) const noexcept {
+        return Growth::NextCapacity(data_.Capacity(), size_ + count, sizeof(T));
+    }
+
+    // Inserts count elements before index. construct(dest, offset, n) builds the source
+    // elements [offset, offset + n) in raw memory at dest. The vector is left unchanged if
+    // construct throws
+    template <typename Construct>
+    iterator InsertN(size_t index, size_t count, Construct construct) {
+        if (count == 0) {
+            return begin() + index;
+        }
+        if (size_ + count > Capacity()) {
+            if constexpr (Memory::CAN_REALLOCATE) {
+                ReallocateBuffer(NextCapacity(count));
+            }
+            else {
+                return InsertRelocating(NextCapacity(count), index, count, construct);
+            }
+        }
+        T* pos = data_ + index;
+        const size_t after = size_ - index;
+        if constexpr (is_trivially_relocatable_v<T>) {
+            data_.Annotate(size_ + count);
+            std::memmove(static_cast<void*>(pos + count), static_cast<const void*>(pos), after * sizeof(T));
+            try {
+                construct(pos, 0, count);
+            }
+            catch (...) {
+                std::memmove(static_cast<void*>(pos), static_cast<const void*>(pos + count), after * sizeof(T));
+                data_.Annotate(size_);
+                throw;
+            }
+        }
+        else if constexpr (std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>) {
+            // The new elements are built in spare capacity first, so only nothrow moves follow
+            T* old_end = end();
+            data_.Annotate(size_ + count);
+            try {
+                construct(old_end, 0, count);
+            }
+            catch (...) {
+                data_.Annotate(size_);
+                throw;
+            }
+            std::rotate(pos, old_end, old_end + count);
         }
         else {
-            std::uninitialized_copy_n(from, size, to);
+            // A throwing move could not be undone in place
+            return InsertRelocating(Capacity(), index, count, construct);
         }
-        std::destroy_n(from, size);
+        size_ += count;
+        data_.Annotate(size_);
+        return begin() + index;
+    }
+
+    template <typename Construct>
+    iterator InsertRelocating(size_t capacity, size_t index, size_t count, Construct& construct) {
+        Memory new_data(capacity, data_.GetAllocator());
+        construct(new_data + index, 0, count);
+        detail::RelocateAround(data_.GetAllocator(), data_.GetAddress(), size_, index, count, new_data.GetAddress());
+        ReplaceBuffer(new_data);
+        size_ += count;
+        data_.Annotate(size_);
+        return begin() + index;
+    }
+
+    VECTOR_CONSTEXPR void CopyOrMove(T* from, size_t size, T* to) {
+        detail::CopyOrMove(data_.GetAllocator(), from, size, to);
     }
 
     static void DestroyN(T* buf, size_t n) noexcept {
@@ -339,6 +1783,48 @@ private:
         new(buf) T(elem);
     }
 
-    RawMemory<T> data_;
+    Memory data_;
     size_t size_ = 0;
 };
+
+// Removes the elements satisfying pred in a single compaction pass and returns their number.
+// Runs of kept trivially copyable elements are moved with memmove
+template <typename T, typename Allocator, typename Growth, typename Stats, typename Predicate>
+size_t EraseIf(Vector<T, Allocator, Growth, Stats>& vector, Predicate pred) {
+    T* const last = vector.Data() + vector.Size();
+    T* out = std::find_if(vector.Data(), last, pred);
+    if (out == last) {
+        return 0;
+    }
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        T* in = out + 1;
+        while (in != last) {
+            T* run_begin = std::find_if_not(in, last, pred);
+            if (run_begin == last) {
+                break;
+            }
+            T* run_end = std::find_if(run_begin + 1, last, pred);
+            const size_t run_size = static_cast<size_t>(run_end - run_begin);
+            std::memmove(static_cast<void*>(out), static_cast<const void*>(run_begin), run_size * sizeof(T));
+            out += run_size;
+            in = run_end == last ? last : run_end + 1;
+        }
+    }
+    else {
+        for (T* in = out + 1; in != last; ++in) {
+            if (!pred(*in)) {
+                *out++ = std::move(*in);
+            }
+        }
+    }
+    const size_t removed = static_cast<size_t>(last - out);
+    vector.Erase(vector.end() - removed, vector.end());
+    return removed;
+}
+
+namespace pmr {
+
+template <typename T, typename Growth = DefaultGrowth>
+using Vector = ::Vector<T, std::pmr::polymorphic_allocator<T>, Growth>;
+
+}  // namespace pmr
@@ -0,0 +1,128 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Zero-copy I/O for vectors of trivially copyable elements: bytes go straight between the
+// descriptor and the vector's buffer without an intermediate copy
+
+template <typename Byte>
+struct ByteSpan {
+    Byte* data = nullptr;
+    size_t size = 0;
+
+    Byte* begin() const noexcept {
+        return data;
+    }
+
+    Byte* end() const noexcept {
+        return data + size;
+    }
+};
+
+template <typename T, typename Allocator, typename Growth, typename Stats>
+ByteSpan<const std::byte> AsBytes(const Vector<T, Allocator, Growth, Stats>& vector) noexcept {
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable elements can be viewed as bytes");
+    return { reinterpret_cast<const std::byte*>(vector.Data()), vector.Size() * sizeof(T) };
+}
+
+template <typename T, typename Allocator, typename Growth, typename Stats>
+ByteSpan<std::byte> AsWritableBytes(Vector<T, Allocator, Growth, Stats>& vector) noexcept {
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable elements can be viewed as bytes");
+    return { reinterpret_cast<std::byte*>(vector.Data()), vector.Size() * sizeof(T) };
+}
+
+namespace detail {
+
+// Repeats readv/writev until every buffer is transferred or, for reads, the end of input.
+// Returns the number of bytes transferred
+template <typename Transfer>
+size_t TransferAll(Transfer transfer, int fd, iovec* buffers, size_t count, const char* what) {
+    size_t total = 0;
+    while (count != 0) {
+        const int batch = static_cast<int>(std::min<size_t>(count, IOV_MAX));
+        const ssize_t done = transfer(fd, buffers, batch);
+        if (done < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+        if (done == 0) {
+            break;
+        }
+        total += static_cast<size_t>(done);
+        // Skip the fully transferred buffers and advance into a partially transferred one
+        size_t left = static_cast<size_t>(done);
+        while (count != 0 && left >= buffers->iov_len) {
+            left -= buffers->iov_len;
+            ++buffers;
+            --count;
+        }
+        if (count != 0) {
+            buffers->iov_base = static_cast<std::byte*>(buffers->iov_base) + left;
+            buffers->iov_len -= left;
+        }
+    }
+    return total;
+}
+
+template <typename T, typename Allocator, typename Growth, typename Stats>
+iovec ToIovec(const Vector<T, Allocator, Growth, Stats>& vector) noexcept {
+    const auto bytes = AsBytes(vector);
+    return { const_cast<std::byte*>(bytes.data), bytes.size };
+}
+
+}  // namespace detail
+
+// Writes the elements of all vectors to fd with as few writev calls as possible
+template <typename... Vectors>
+void WriteAll(int fd, const Vectors&... vectors) {
+    static_assert(sizeof...(Vectors) > 0, "WriteAll needs at least one vector");
+    iovec buffers[] = { detail::ToIovec(vectors)... };
+    size_t bytes = 0;
+    for (const iovec& buffer : buffers) {
+        bytes += buffer.iov_len;
+    }
+    if (detail::TransferAll(writev, fd, buffers, sizeof...(Vectors), "writev") != bytes) {
+        throw std::runtime_error("writev: descriptor stopped accepting data");
+    }
+}
+
+template <typename T, typename Allocator, typename Growth, typename Stats>
+void WriteTo(int fd, const Vector<T, Allocator, Growth, Stats>& vector) {
+    WriteAll(fd, vector);
+}
+
+// Appends up to count elements read from fd and returns how many were read (fewer at end
+// of input). Bytes land directly in space prepared at the end of the vector, which is never
+// value-initialized and grows by the vector's policy, so chunked reads stay linear overall
+template <typename T, typename Allocator, typename Growth, typename Stats>
+size_t ReadFrom(int fd, Vector<T, Allocator, Growth, Stats>& vector, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_default_constructible_v<T>,
+                  "elements are read as raw bytes");
+    T* out = vector.PrepareAppend(count);
+    size_t bytes = 0;
+    try {
+        iovec buffer{ out, count * sizeof(T) };
+        bytes = detail::TransferAll(readv, fd, &buffer, 1, "readv");
+        if (bytes % sizeof(T) != 0) {
+            throw std::runtime_error("readv: input ends in the middle of an element");
+        }
+    }
+    catch (...) {
+        vector.CommitAppend(0);
+        throw;
+    }
+    vector.CommitAppend(bytes / sizeof(T));
+    return bytes / sizeof(T);
+}
@@ -0,0 +1,396 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+// Bulk kernels over contiguous ranges of arithmetic values given as pointers, e.g.
+// Vector::Data() and Data() + Size(), which stay raw pointers under VECTOR_DEBUG_ITERATORS.
+// Every kernel is written once over GCC/Clang vector extensions and instantiated for each
+// instruction set; the widest one the CPU supports is picked at run time. Loads are unaligned,
+// which costs nothing on the aligned buffers of AlignedVector. Floating point reductions
+// add lanes in a different order than a scalar loop, and NaNs are not supported
+namespace vector_ops {
+
+enum class Isa {
+    SCALAR,
+    SSE2,
+    AVX2,
+    AVX512,
+    NEON,
+};
+
+// Widest instruction set supported by this CPU
+inline Isa DetectIsa() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return Isa::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return Isa::AVX2;
+    }
+    return Isa::SSE2;
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+    return Isa::NEON;
+#else
+    return Isa::SCALAR;
+#endif
+}
+
+namespace detail {
+
+inline std::atomic<Isa>& ActiveIsaStorage() noexcept {
+    static std::atomic<Isa> isa = DetectIsa();
+    return isa;
+}
+
+}  // namespace detail
+
+inline Isa ActiveIsa() noexcept {
+    return detail::ActiveIsaStorage().load(std::memory_order_relaxed);
+}
+
+// Makes the kernels use isa, which must not be wider than DetectIsa(). Meant for tests and
+// for comparing instruction sets in benchmarks
+inline void ForceIsa(Isa isa) noexcept {
+    detail::ActiveIsaStorage().store(isa, std::memory_order_relaxed);
+}
+
+namespace detail {
+
+#define VECTOR_OPS_INLINE inline __attribute__((always_inline))
+
+template <typename T, size_t Width>
+struct Lanes {
+    typedef T type __attribute__((vector_size(Width)));
+    static constexpr size_t COUNT = Width / sizeof(T);
+};
+
+// Vectors are passed by reference only: passing them by value between functions that target
+// different instruction sets would not agree on the calling convention
+template <typename V, typename T>
+VECTOR_OPS_INLINE void Load(V& v, const T* from) noexcept {
+    std::memcpy(&v, from, sizeof(V));
+}
+
+template <typename V, typename T>
+VECTOR_OPS_INLINE void Store(T* to, const V& v) noexcept {
+    std::memcpy(to, &v, sizeof(V));
+}
+
+template <typename V, typename T>
+VECTOR_OPS_INLINE void Splat(V& v, T value) noexcept {
+    v = V{} + value;
+}
+
+template <typename Mask>
+VECTOR_OPS_INLINE bool AnyLane(const Mask& mask) noexcept {
+    uint64_t words[sizeof(Mask) / sizeof(uint64_t)];
+    std::memcpy(words, &mask, sizeof(Mask));
+    uint64_t any = 0;
+    for (uint64_t word : words) {
+        any |= word;
+    }
+    return any != 0;
+}
+
+template <typename R, typename V>
+VECTOR_OPS_INLINE R AddLanes(const V& v) noexcept {
+    R sum{};
+    for (size_t i = 0; i < sizeof(V) / sizeof(v[0]); ++i) {
+        sum += static_cast<R>(v[i]);
+    }
+    return sum;
+}
+
+// Sums of integers are accumulated in 64 bits, floating point sums in T
+template <typename T>
+using SumType = std::conditional_t<std::is_floating_point_v<T>, T,
+                                   std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>>;
+
+struct FillOp {
+    template <size_t Width, typename T>
+    static VECTOR_OPS_INLINE void Run(T* data, size_t n, T value) noexcept {
+        using L = Lanes<T, Width>;
+        typename L::type v;
+        Splat(v, value);
+        size_t i = 0;
+        for (; i + L::COUNT <= n; i += L::COUNT) {
+            Store(data + i, v);
+        }
+        for (; i < n; ++i) {
+            data[i] = value;
+        }
+    }
+};
+
+struct SumOp {
+    static constexpr size_t UNROLL = 4;
+
+    template <size_t Width, typename T>
+    static VECTOR_OPS_INLINE SumType<T> Run(const T* data, size_t n) noexcept {
+        using R = SumType<T>;
+        using L = Lanes<T, Width>;
+        // Small integers first widen to 32 bits, which cannot overflow within FLUSH_BLOCKS
+        using Partial = std::conditional_t<(sizeof(T) < 4), std::conditional_t<std::is_signed_v<T>, int32_t, uint32_t>, R>;
+        using P = Lanes<Partial, L::COUNT * sizeof(Partial)>;
+        using W = Lanes<R, L::COUNT * sizeof(R)>;
+        constexpr size_t FLUSH_BLOCKS = std::is_same_v<Partial, R> ? static_cast<size_t>(-1) : size_t{1} << 16;
+
+        typename W::type total = {};
+        size_t i = 0;
+        while (i + L::COUNT * UNROLL <= n) {
+            typename P::type partial[UNROLL] = {};
+            for (size_t blocks = 0; blocks < FLUSH_BLOCKS && i + L::COUNT * UNROLL <= n; ++blocks) {
+                for (size_t u = 0; u < UNROLL; ++u, i += L::COUNT) {
+                    typename L::type chunk;
+                    Load(chunk, data + i);
+                    partial[u] += __builtin_convertvector(chunk, typename P::type);
+                }
+            }
+            for (size_t u = 0; u < UNROLL; ++u) {
+                total += __builtin_convertvector(partial[u], typename W::type);
+            }
+        }
+        R sum = AddLanes<R>(total);
+        for (; i < n; ++i) {
+            sum += static_cast<R>(data[i]);
+        }
+        return sum;
+    }
+};
+
+struct MinMaxOp {
+    template <size_t Width, typename T>
+    static VECTOR_OPS_INLINE std::pair<T, T> Run(const T* data, size_t n) noexcept {
+        using L = Lanes<T, Width>;
+        T lo = data[0];
+        T hi = data[0];
+        size_t i = 0;
+        if (n >= L::COUNT) {
+            typename L::type lo_lanes;
+            typename L::type hi_lanes;
+            Load(lo_lanes, data);
+            hi_lanes = lo_lanes;
+            for (i = L::COUNT; i + L::COUNT <= n; i += L::COUNT) {
+                typename L::type chunk;
+                Load(chunk, data + i);
+                lo_lanes = chunk < lo_lanes ? chunk : lo_lanes;
+                hi_lanes = hi_lanes < chunk ? chunk : hi_lanes;
+            }
+            for (size_t lane = 0; lane < L::COUNT; ++lane) {
+                lo = std::min(lo, static_cast<T>(lo_lanes[lane]));
+                hi = std::max(hi, static_cast<T>(hi_lanes[lane]));
+            }
+        }
+        for (; i < n; ++i) {
+            lo = std::min(lo, data[i]);
+            hi = std::max(hi, data[i]);
+        }
+        return { lo, hi };
+    }
+};
+
+struct FindOp {
+    template <size_t Width, typename T>
+    static VECTOR_OPS_INLINE size_t Run(const T* data, size_t n, T value) noexcept {
+        using L = Lanes<T, Width>;
+        typename L::type needle;
+        Splat(needle, value);
+        size_t i = 0;
+        for (; i + L::COUNT <= n; i += L::COUNT) {
+            typename L::type chunk;
+            Load(chunk, data + i);
+            if (AnyLane(chunk == needle)) {
+                break;
+            }
+        }
+        for (; i < n; ++i) {
+            if (data[i] == value) {
+                return i;
+            }
+        }
+        return n;
+    }
+};
+
+struct CountOp {
+    template <size_t Width, typename T>
+    static VECTOR_OPS_INLINE size_t Run(const T* data, size_t n, T value) noexcept {
+        using L = Lanes<T, Width>;
+        typename L::type needle;
+        Splat(needle, value);
+        using Mask = decltype(needle == needle);
+        // Matching lanes are -1, so every lane counts down; it is drained before it can wrap
+        using Lane = std::remove_reference_t<decltype(std::declval<Mask>()[0])>;
+        constexpr size_t FLUSH_BLOCKS = std::min<uint64_t>(std::numeric_limits<Lane>::max(), uint64_t{1} << 30);
+
+        size_t count = 0;
+        size_t i = 0;
+        while (i + L::COUNT <= n) {
+            Mask counters = {};
+            for (size_t blocks = 0; blocks < FLUSH_BLOCKS && i + L::COUNT <= n; ++blocks, i += L::COUNT) {
+                typename L::type chunk;
+                Load(chunk, data + i);
+                counters += chunk == needle;
+            }
+            for (size_t lane = 0; lane < L::COUNT; ++lane) {
+                count += static_cast<size_t>(-static_cast<int64_t>(counters[lane]));
+            }
+        }
+        for (; i < n; ++i) {
+            count += data[i] == value;
+        }
+        return count;
+    }
+};
+
+struct MismatchOp {
+    template <size_t Width, typename T>
+    static VECTOR_OPS_INLINE size_t Run(const T* lhs, const T* rhs, size_t n) noexcept {
+        using L = Lanes<T, Width>;
+        size_t i = 0;
+        for (; i + L::COUNT <= n; i += L::COUNT) {
+            typename L::type a;
+            typename L::type b;
+            Load(a, lhs + i);
+            Load(b, rhs + i);
+            if (AnyLane(a != b)) {
+                break;
+            }
+        }
+        for (; i < n; ++i) {
+            if (lhs[i] != rhs[i]) {
+                return i;
+            }
+        }
+        return n;
+    }
+};
+
+// The operation is called on 16-byte lane groups, the widest vectors that every instruction
+// set passes to a non-inlined call the same way; wider targets still run its body with their
+// own instructions once it is inlined
+struct TransformOp {
+    template <size_t Width, typename T, typename Operation>
+    static VECTOR_OPS_INLINE void Run(const T* from, size_t n, T* to, Operation& op) {
+        using L = Lanes<T, 16>;
+        size_t i = 0;
+        if constexpr (std::is_invocable_r_v<typename L::type, Operation&, typename L::type>) {
+            for (; i + L::COUNT <= n; i += L::COUNT) {
+                typename L::type chunk;
+                Load(chunk, from + i);
+                chunk = op(chunk);
+                Store(to + i, chunk);
+            }
+        }
+        for (; i < n; ++i) {
+            to[i] = static_cast<T>(op(from[i]));
+        }
+    }
+};
+
+// One instantiation of every kernel per instruction set
+#if defined(__x86_64__) || defined(__i386__)
+template <typename Op, typename... Args>
+__attribute__((target("avx512f,avx512bw"))) decltype(auto) RunAvx512(Args&&... args) {
+    return Op::template Run<64>(std::forward<Args>(args)...);
+}
+
+template <typename Op, typename... Args>
+__attribute__((target("avx2"))) decltype(auto) RunAvx2(Args&&... args) {
+    return Op::template Run<32>(std::forward<Args>(args)...);
+}
+#endif
+
+template <typename Op, typename... Args>
+decltype(auto) RunBaseline(Args&&... args) {
+    return Op::template Run<16>(std::forward<Args>(args)...);
+}
+
+template <typename Op, typename... Args>
+decltype(auto) Dispatch(Args&&... args) {
+#if defined(__x86_64__) || defined(__i386__)
+    switch (ActiveIsa()) {
+    case Isa::AVX512:
+        return RunAvx512<Op>(std::forward<Args>(args)...);
+    case Isa::AVX2:
+        return RunAvx2<Op>(std::forward<Args>(args)...);
+    default:
+        break;
+    }
+#endif
+    return RunBaseline<Op>(std::forward<Args>(args)...);
+}
+
+template <typename T>
+inline constexpr bool IS_SUPPORTED = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+
+#undef VECTOR_OPS_INLINE
+
+}  // namespace detail
+
+template <typename T>
+void Fill(T* first, T* last, T value) noexcept {
+    static_assert(detail::IS_SUPPORTED<T>);
+    detail::Dispatch<detail::FillOp>(first, static_cast<size_t>(last - first), value);
+}
+
+template <typename T>
+detail::SumType<T> Sum(const T* first, const T* last) noexcept {
+    static_assert(detail::IS_SUPPORTED<T>);
+    return detail::Dispatch<detail::SumOp>(first, static_cast<size_t>(last - first));
+}
+
+// Returns the smallest and the largest element of a non-empty range
+template <typename T>
+std::pair<T, T> MinMax(const T* first, const T* last) noexcept {
+    static_assert(detail::IS_SUPPORTED<T>);
+    assert(first != last);
+    return detail::Dispatch<detail::MinMaxOp>(first, static_cast<size_t>(last - first));
+}
+
+// Returns the first element equal to value, or last
+template <typename T>
+T* Find(T* first, T* last, std::remove_const_t<T> value) noexcept {
+    static_assert(detail::IS_SUPPORTED<std::remove_const_t<T>>);
+    const size_t n = static_cast<size_t>(last - first);
+    return first + detail::Dispatch<detail::FindOp>(static_cast<const std::remove_const_t<T>*>(first), n, value);
+}
+
+template <typename T>
+size_t Count(const T* first, const T* last, T value) noexcept {
+    static_assert(detail::IS_SUPPORTED<T>);
+    return detail::Dispatch<detail::CountOp>(first, static_cast<size_t>(last - first), value);
+}
+
+// Writes op(x) for every x of [first, last) to `to`, which may be first. Operations that
+// accept lane vectors as well as T -- generic lambdas using arithmetic operators do -- are
+// applied to whole vectors
+template <typename T, typename Operation>
+void Transform(const T* first, const T* last, T* to, Operation op) {
+    static_assert(detail::IS_SUPPORTED<T>);
+    detail::Dispatch<detail::TransformOp>(first, static_cast<size_t>(last - first), to, op);
+}
+
+// Three-way lexicographical comparison: negative if [lhs_first, lhs_last) orders before
+// [rhs_first, rhs_last), zero if they are equal and positive otherwise
+template <typename T>
+int Compare(const T* lhs_first, const T* lhs_last, const T* rhs_first, const T* rhs_last) noexcept {
+    static_assert(detail::IS_SUPPORTED<T>);
+    const size_t lhs_size = static_cast<size_t>(lhs_last - lhs_first);
+    const size_t rhs_size = static_cast<size_t>(rhs_last - rhs_first);
+    const size_t common = std::min(lhs_size, rhs_size);
+    const size_t index = detail::Dispatch<detail::MismatchOp>(lhs_first, rhs_first, common);
+    if (index != common) {
+        return lhs_first[index] < rhs_first[index] ? -1 : 1;
+    }
+    return lhs_size < rhs_size ? -1 : (lhs_size == rhs_size ? 0 : 1);
+}
+
+}  // namespace vector_ops
@@ -0,0 +1,267 @@
+#pragma once
+#include "vector_stats.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The hooks must stay real functions: a clone made by the optimizer has no symbol, and the
+// unwinder would report it as the call site
+#if defined(__clang__)
+#define VECTOR_PROFILE_HOOK __attribute__((noinline))
+#else
+#define VECTOR_PROFILE_HOOK __attribute__((noinline, noclone))
+#endif
+
+// Stats policy that attributes vector memory to call sites: for every site it records how
+// many of the vectors that allocated there were destroyed, the capacity they held against
+// the bytes actually used, and how often they reallocated, and it tracks live and peak
+// bytes for all such vectors. The site of a vector is taken when its first block is
+// allocated and passed on to every block it grows into, so a vector that is returned or
+// moved into a member is still charged to the code that sized it. A site is the innermost
+// function on the stack outside Vector, RawMemory and std; naming it needs the
+// executable's symbols (-rdynamic), otherwise it is shown as an address. Every block
+// allocation, including each reallocation, pays for a backtrace and its symbol lookups.
+// The state is kept with std containers, so the profiler never profiles itself
+class VectorProfiler {
+public:
+    struct Site {
+        std::string name;
+        uint64_t vectors = 0;
+        uint64_t reallocations = 0;
+        uint64_t capacity_bytes = 0;
+        uint64_t size_bytes = 0;
+        uint64_t largest_capacity_bytes = 0;
+
+        // Share of the released capacity that held elements
+        double Utilization() const noexcept {
+            return capacity_bytes == 0 ? 1.0 : static_cast<double>(size_bytes) / static_cast<double>(capacity_bytes);
+        }
+    };
+
+    static void OnAllocate(size_t bytes) noexcept {
+        std::lock_guard lock(GetState().mutex);
+        State& state = GetState();
+        state.live_bytes += bytes;
+        state.peak_bytes = std::max(state.peak_bytes, state.live_bytes);
+    }
+
+    VECTOR_PROFILE_HOOK static void OnBlockAllocated(const void* block, size_t /*bytes*/) noexcept {
+        const std::string name = CallSite();
+        std::lock_guard lock(GetState().mutex);
+        try {
+            GetState().blocks[block] = name;
+        }
+        catch (...) {
+        }
+    }
+
+    static void OnBlockFreed(const void* block, size_t bytes) noexcept {
+        std::lock_guard lock(GetState().mutex);
+        State& state = GetState();
+        state.live_bytes -= bytes;
+        state.blocks.erase(block);
+    }
+
+    // OnAllocate has already counted the new size
+    static void OnBlockMoved(const void* old_block, const void* new_block, size_t old_bytes,
+                             size_t /*new_bytes*/) noexcept {
+        std::lock_guard lock(GetState().mutex);
+        State& state = GetState();
+        state.live_bytes -= old_bytes;
+        auto node = state.blocks.extract(old_block);
+        if (!node.empty()) {
+            node.key() = new_block;
+            state.blocks.insert(std::move(node));
+        }
+    }
+
+    // The new block takes over the site of the block it replaces
+    VECTOR_PROFILE_HOOK static void OnReallocate(const ReallocationEvent& event) noexcept {
+        std::string name = SiteOf(event.old_block);
+        if (name.empty()) {
+            name = SiteOf(event.new_block);
+        }
+        if (name.empty()) {
+            name = CallSite();
+        }
+        std::lock_guard lock(GetState().mutex);
+        try {
+            GetState().blocks[event.new_block] = name;
+        }
+        catch (...) {
+        }
+        if (Site* site = FindSite(name)) {
+            ++site->reallocations;
+        }
+    }
+
+    VECTOR_PROFILE_HOOK static void OnRelease(const ReleaseEvent& event) noexcept {
+        std::string name = SiteOf(event.block);
+        if (name.empty()) {
+            name = CallSite();
+        }
+        std::lock_guard lock(GetState().mutex);
+        if (Site* site = FindSite(name)) {
+            ++site->vectors;
+            site->capacity_bytes += event.capacity_bytes;
+            site->size_bytes += event.size_bytes;
+            site->largest_capacity_bytes = std::max<uint64_t>(site->largest_capacity_bytes, event.capacity_bytes);
+        }
+    }
+
+    // Sites ordered by the capacity they left unused, largest first
+    static std::vector<Site> Sites() {
+        std::vector<Site> sites;
+        {
+            std::lock_guard lock(GetState().mutex);
+            for (const auto& [name, site] : GetState().sites) {
+                sites.push_back(site);
+            }
+        }
+        std::stable_sort(sites.begin(), sites.end(), [](const Site& lhs, const Site& rhs) {
+            return lhs.capacity_bytes - lhs.size_bytes > rhs.capacity_bytes - rhs.size_bytes;
+        });
+        return sites;
+    }
+
+    static uint64_t LiveBytes() noexcept {
+        std::lock_guard lock(GetState().mutex);
+        return GetState().live_bytes;
+    }
+
+    static uint64_t PeakBytes() noexcept {
+        std::lock_guard lock(GetState().mutex);
+        return GetState().peak_bytes;
+    }
+
+    // Forgets the sites and restarts the peak from the bytes live now. Live vectors keep
+    // the sites they were allocated at
+    static void Reset() noexcept {
+        std::lock_guard lock(GetState().mutex);
+        State& state = GetState();
+        state.sites.clear();
+        state.peak_bytes = state.live_bytes;
+    }
+
+    static void Report(std::ostream& out) {
+        const std::vector<Site> sites = Sites();
+        out << "vector profile: peak " << PeakBytes() << " bytes, live " << LiveBytes() << " bytes\n";
+        for (const Site& site : sites) {
+            out << std::setw(6) << std::fixed << std::setprecision(1) << site.Utilization() * 100 << "% used  "
+                << site.capacity_bytes - site.size_bytes << " bytes unused  " << site.vectors << " vectors  "
+                << site.reallocations << " reallocations  largest " << site.largest_capacity_bytes << " bytes  "
+                << site.name << '\n';
+        }
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::map<std::string, Site> sites;
+        // Site of every live block
+        std::map<const void*, std::string> blocks;
+        uint64_t live_bytes = 0;
+        uint64_t peak_bytes = 0;
+    };
+
+    // Never destroyed, so vectors that outlive static destruction can still report to it
+    static State& GetState() noexcept {
+        static State* state = new State;
+        return *state;
+    }
+
+    // Site recorded for block, or an empty string if there is none
+    static std::string SiteOf(const void* block) noexcept {
+        std::lock_guard lock(GetState().mutex);
+        const auto& blocks = GetState().blocks;
+        const auto it = blocks.find(block);
+        try {
+            return it != blocks.end() ? it->second : std::string();
+        }
+        catch (...) {
+            return {};
+        }
+    }
+
+    // Returns nullptr if the site cannot be recorded for lack of memory
+    static Site* FindSite(const std::string& name) noexcept {
+        try {
+            Site& site = GetState().sites[name];
+            site.name = name;
+            return &site;
+        }
+        catch (...) {
+            return nullptr;
+        }
+    }
+
+    static bool IsLibraryFrame(const std::string& name) {
+        const std::string scope = name.substr(0, name.find('('));
+        const auto starts_scope = [&scope](const char* prefix) {
+            const size_t pos = scope.find(prefix);
+            return pos == 0 || (pos != std::string::npos && scope[pos - 1] == ' ');
+        };
+        return scope.find("Vector<") != std::string::npos || scope.find("RawMemory<") != std::string::npos
+            || scope.find("VectorProfiler") != std::string::npos || starts_scope("std::")
+            || starts_scope("detail::");
+    }
+
+    VECTOR_PROFILE_HOOK static std::string CallSite() noexcept {
+        try {
+            void* frames[32];
+            const int count = backtrace(frames, 32);
+            for (int i = 1; i < count; ++i) {
+                Dl_info info{};
+                if (dladdr(frames[i], &info) == 0) {
+                    continue;
+                }
+                if (info.dli_sname == nullptr) {
+                    // No symbol: report the offset into the object for addr2line
+                    std::ostringstream out;
+                    out << (info.dli_fname != nullptr ? info.dli_fname : "?") << "+0x" << std::hex
+                        << reinterpret_cast<uintptr_t>(frames[i]) - reinterpret_cast<uintptr_t>(info.dli_fbase);
+                    return out.str();
+                }
+                int status = 0;
+                char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                const std::string name = status == 0 ? demangled : info.dli_sname;
+                std::free(demangled);
+                if (!IsLibraryFrame(name)) {
+                    return name;
+                }
+            }
+        }
+        catch (...) {
+        }
+        return "<unknown>";
+    }
+
+#if defined(VECTOR_PROFILE)
+    // Prints the report to stderr when the program exits
+    struct ExitReporter {
+        ~ExitReporter();
+    };
+
+    static inline const ExitReporter exit_reporter_{};
+#endif
+};
+
+#if defined(VECTOR_PROFILE)
+#include <iostream>
+
+inline VectorProfiler::ExitReporter::~ExitReporter() {
+    VectorProfiler::Report(std::cerr);
+}
+#endif
@@ -0,0 +1,174 @@
+#pragma once
+#include "vector.h"
+
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+#if !defined(VECTOR_HAS_COROUTINES)
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define VECTOR_HAS_COROUTINES 1
+#else
+#define VECTOR_HAS_COROUTINES 0
+#endif
+#endif
+
+#if VECTOR_HAS_COROUTINES
+#include <coroutine>
+#endif
+
+// Uninitialized space at the end of a vector, handed out by VectorSink
+template <typename T>
+struct AppendBuffer {
+    T* data = nullptr;
+    size_t size = 0;
+
+    T* begin() const noexcept {
+        return data;
+    }
+
+    T* end() const noexcept {
+        return data + size;
+    }
+
+    T& operator[](size_t index) const noexcept {
+        assert(index < size);
+        return data[index];
+    }
+};
+
+// Batched appender for decoders: Prepare(n) returns space for n elements in the vector's own
+// storage and Commit(k) adds the first k of them once they are constructed, so a chunk is
+// decoded in place with one capacity check. Nothing but the prepared space may be touched
+// in between. The sink holds only a pointer to the vector and may be kept across co_await
+template <typename Vec>
+class VectorSink {
+public:
+    using value_type = typename Vec::value_type;
+
+    explicit VectorSink(Vec& vector) noexcept
+        : vector_(&vector) {
+    }
+
+    AppendBuffer<value_type> Prepare(size_t count) {
+        return { vector_->PrepareAppend(count), count };
+    }
+
+    void Commit(size_t count) noexcept {
+        vector_->CommitAppend(count);
+    }
+
+    Vec& GetVector() const noexcept {
+        return *vector_;
+    }
+
+private:
+    Vec* vector_;
+};
+
+#if VECTOR_HAS_COROUTINES
+// Return type of producer coroutines that decode straight into a vector. The producer gets
+// its first buffer with `AppendBuffer<T> buffer = co_yield 0;`, constructs elements at the
+// front of it and adds them with `buffer = co_yield written;`, which also hands over the
+// next buffer. Returning ends the stream; an exception is rethrown by AppendTo after the
+// elements added so far are in place. Elements constructed but not added are not destroyed
+template <typename T>
+class AppendGenerator {
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type {
+        AppendBuffer<T> buffer;
+        size_t written = 0;
+        std::exception_ptr exception;
+
+        AppendGenerator get_return_object() noexcept {
+            return AppendGenerator(Handle::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+
+        auto yield_value(size_t count) noexcept {
+            struct NextBuffer {
+                promise_type& promise;
+
+                bool await_ready() const noexcept {
+                    return false;
+                }
+
+                void await_suspend(Handle) const noexcept {
+                }
+
+                AppendBuffer<T> await_resume() const noexcept {
+                    return promise.buffer;
+                }
+            };
+            written = count;
+            return NextBuffer{ *this };
+        }
+
+        void return_void() noexcept {
+        }
+
+        void unhandled_exception() noexcept {
+            exception = std::current_exception();
+        }
+    };
+
+    AppendGenerator(AppendGenerator&& other) noexcept
+        : handle_(std::exchange(other.handle_, nullptr)) {
+    }
+
+    AppendGenerator& operator=(AppendGenerator&& rhs) noexcept {
+        std::swap(handle_, rhs.handle_);
+        return *this;
+    }
+
+    ~AppendGenerator() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    // Runs the producer to completion, giving it chunk elements of space at a time.
+    // Returns the number of elements appended
+    template <typename Vec>
+    size_t AppendTo(Vec& vector, size_t chunk) {
+        static_assert(std::is_same_v<typename Vec::value_type, T>, "the vector must hold T");
+        assert(handle_ && !handle_.done() && chunk > 0);
+        VectorSink<Vec> sink(vector);
+        const size_t old_size = vector.Size();
+        promise_type& promise = handle_.promise();
+        promise.buffer = {};
+        handle_.resume();
+        while (!handle_.done()) {
+            assert(promise.written <= promise.buffer.size);
+            sink.Commit(promise.written);
+            promise.buffer = sink.Prepare(chunk);
+            handle_.resume();
+        }
+        // Gives back the space prepared for the resumption that ended the stream
+        sink.Commit(0);
+        if (promise.exception) {
+            std::rethrow_exception(promise.exception);
+        }
+        return vector.Size() - old_size;
+    }
+
+private:
+    explicit AppendGenerator(Handle handle) noexcept
+        : handle_(handle) {
+    }
+
+    Handle handle_;
+};
+#endif
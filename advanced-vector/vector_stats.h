@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Describes a reallocation: old_block of old_bytes was replaced by new_block of new_bytes and
+// `moved` elements were relocated by move (or bitwise), `copied` by the copy fallback.
+// old_block may already be freed
+struct ReallocationEvent {
+    const void* old_block = nullptr;
+    const void* new_block = nullptr;
+    size_t old_bytes = 0;
+    size_t new_bytes = 0;
+    size_t moved = 0;
+    size_t copied = 0;
+};
+
+// Describes a vector destroyed while owning block of capacity_bytes, size_bytes of which
+// held elements
+struct ReleaseEvent {
+    const void* block = nullptr;
+    size_t capacity_bytes = 0;
+    size_t size_bytes = 0;
+};
+
+// Stats policy of RawMemory/Vector that records nothing; its hooks compile away
+struct NoVectorStats {
+    static void OnAllocate(size_t /*bytes*/) noexcept {
+    }
+
+    static void OnReallocate(const ReallocationEvent& /*event*/) noexcept {
+    }
+};
+
+// Stats policy with process-wide counters. Vectors sharing a Tag share the counters,
+// which are updated with relaxed atomics and may be read from any thread
+template <typename Tag = void>
+class VectorStats {
+public:
+    using Hook = void (*)(const ReallocationEvent& event);
+
+    struct Snapshot {
+        uint64_t allocations = 0;
+        uint64_t bytes_allocated = 0;
+        uint64_t reallocations = 0;
+        uint64_t moved = 0;
+        uint64_t copied = 0;
+        uint64_t peak_capacity_bytes = 0;
+    };
+
+    static void OnAllocate(size_t bytes) noexcept {
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        bytes_allocated_.fetch_add(bytes, std::memory_order_relaxed);
+        uint64_t peak = peak_capacity_bytes_.load(std::memory_order_relaxed);
+        while (peak < bytes && !peak_capacity_bytes_.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {
+        }
+    }
+
+    static void OnReallocate(const ReallocationEvent& event) noexcept {
+        reallocations_.fetch_add(1, std::memory_order_relaxed);
+        moved_.fetch_add(event.moved, std::memory_order_relaxed);
+        copied_.fetch_add(event.copied, std::memory_order_relaxed);
+        if (event.new_bytes >= hook_threshold_bytes_.load(std::memory_order_relaxed)) {
+            if (Hook hook = hook_.load(std::memory_order_acquire)) {
+                hook(event);
+            }
+        }
+    }
+
+    // Calls hook for every reallocation to a buffer of at least threshold_bytes.
+    // Passing nullptr removes the hook. The hook must not throw
+    static void SetReallocationHook(size_t threshold_bytes, Hook hook) noexcept {
+        hook_threshold_bytes_.store(threshold_bytes, std::memory_order_relaxed);
+        hook_.store(hook, std::memory_order_release);
+    }
+
+    static Snapshot Get() noexcept {
+        Snapshot snapshot;
+        snapshot.allocations = allocations_.load(std::memory_order_relaxed);
+        snapshot.bytes_allocated = bytes_allocated_.load(std::memory_order_relaxed);
+        snapshot.reallocations = reallocations_.load(std::memory_order_relaxed);
+        snapshot.moved = moved_.load(std::memory_order_relaxed);
+        snapshot.copied = copied_.load(std::memory_order_relaxed);
+        snapshot.peak_capacity_bytes = peak_capacity_bytes_.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    static void Reset() noexcept {
+        allocations_.store(0, std::memory_order_relaxed);
+        bytes_allocated_.store(0, std::memory_order_relaxed);
+        reallocations_.store(0, std::memory_order_relaxed);
+        moved_.store(0, std::memory_order_relaxed);
+        copied_.store(0, std::memory_order_relaxed);
+        peak_capacity_bytes_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static inline std::atomic<uint64_t> allocations_ = 0;
+    static inline std::atomic<uint64_t> bytes_allocated_ = 0;
+    static inline std::atomic<uint64_t> reallocations_ = 0;
+    static inline std::atomic<uint64_t> moved_ = 0;
+    static inline std::atomic<uint64_t> copied_ = 0;
+    static inline std::atomic<uint64_t> peak_capacity_bytes_ = 0;
+    static inline std::atomic<size_t> hook_threshold_bytes_ = 0;
+    static inline std::atomic<Hook> hook_ = nullptr;
+};
+
+// Building with VECTOR_STATS turns counting on for every vector that does not pick a policy,
+// and VECTOR_PROFILE the per-call-site profile that is printed at exit
+#if defined(VECTOR_STATS)
+using DefaultVectorStats = VectorStats<>;
+#elif defined(VECTOR_PROFILE)
+#include "vector_profile.h"
+using DefaultVectorStats = VectorProfiler;
+#else
+using DefaultVectorStats = NoVectorStats;
+#endif